@@ -0,0 +1,141 @@
+#ifndef INTERNER_HPP
+#define INTERNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Плотный номер строки в пуле; 0 означает "нет символа"
+using SymbolId = uint32_t;
+constexpr SymbolId NO_SYMBOL = 0;
+
+// Пул строк: каждая различная лексема хранится один раз в блоках памяти,
+// а лексер, парсер и анализатор работают с её номером SymbolId.
+// Номера выдаются подряд начиная с 1 в порядке первого появления.
+class Interner {
+public:
+    Interner() {
+        names.push_back(std::string_view()); // NO_SYMBOL
+        hashes.push_back(0);
+        slots.assign(INITIAL_SLOTS, NO_SYMBOL);
+    }
+
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    // Возвращает номер строки, добавляя её при первом обращении
+    SymbolId intern(std::string_view text) {
+        uint32_t hash = hashOf(text);
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            SymbolId id = slots[i];
+            if (id == NO_SYMBOL) {
+                id = static_cast<SymbolId>(names.size());
+                names.push_back(store(text));
+                hashes.push_back(hash);
+                slots[i] = id;
+                if (names.size() * 4 > slots.size() * 3) {
+                    grow();
+                }
+                return id;
+            }
+            if (hashes[id] == hash && names[id] == text) {
+                return id;
+            }
+        }
+    }
+
+    // intern() для нескольких потоков сразу. Пока такие потоки работают,
+    // все они добавляют строки только через internShared(), а name() для
+    // новых номеров читается после их завершения
+    SymbolId internShared(std::string_view text) {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        return intern(text);
+    }
+
+    // Номер уже добавленной строки или NO_SYMBOL
+    SymbolId find(std::string_view text) const {
+        uint32_t hash = hashOf(text);
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            SymbolId id = slots[i];
+            if (id == NO_SYMBOL || (hashes[id] == hash && names[id] == text)) {
+                return id;
+            }
+        }
+    }
+
+    std::string_view name(SymbolId id) const {
+        return names[id];
+    }
+
+    size_t size() const {
+        return names.size() - 1;
+    }
+
+    // Общий пул для всех стадий трансляции
+    static Interner& global() {
+        static Interner instance;
+        return instance;
+    }
+
+private:
+    static constexpr size_t INITIAL_SLOTS = 1024;
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    static uint32_t hashOf(std::string_view text) {
+        uint32_t hash = 2166136261u; // FNV-1a
+        for (unsigned char c : text) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Копирует текст в текущий блок; длинные строки получают свой блок
+    std::string_view store(std::string_view text) {
+        if (text.empty()) {
+            return std::string_view();
+        }
+        if (text.size() > BLOCK_SIZE / 4) {
+            blocks.emplace_back(new char[text.size()]);
+            std::memcpy(blocks.back().get(), text.data(), text.size());
+            return std::string_view(blocks.back().get(), text.size());
+        }
+        if (!currentBlock || blockUsed + text.size() > BLOCK_SIZE) {
+            blocks.emplace_back(new char[BLOCK_SIZE]);
+            currentBlock = blocks.back().get();
+            blockUsed = 0;
+        }
+        char* copy = currentBlock + blockUsed;
+        std::memcpy(copy, text.data(), text.size());
+        blockUsed += text.size();
+        return std::string_view(copy, text.size());
+    }
+
+    void grow() {
+        std::vector<SymbolId> bigger(slots.size() * 2, NO_SYMBOL);
+        size_t mask = bigger.size() - 1;
+        for (SymbolId id = 1; id < names.size(); id++) {
+            size_t i = hashes[id] & mask;
+            while (bigger[i] != NO_SYMBOL) {
+                i = (i + 1) & mask;
+            }
+            bigger[i] = id;
+        }
+        slots.swap(bigger);
+    }
+
+    std::vector<std::string_view> names;
+    std::vector<uint32_t> hashes;
+    std::vector<SymbolId> slots;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* currentBlock = nullptr;
+    size_t blockUsed = 0;
+    std::mutex sharedMutex;
+};
+
+#endif // INTERNER_HPP
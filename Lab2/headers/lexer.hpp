@@ -0,0 +1,754 @@
+#ifndef LEXER_HPP
+#define LEXER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "interner.hpp"
+#include "lexicon.hpp"
+#include "scanner.hpp"
+#include "source_loc.hpp"
+#include "unicode.hpp"
+
+// Типы токенов
+enum TokenType {
+    KEYWORD,
+    IDENTIFIER,
+    NUMBER,
+    FLOAT_NUMBER,
+    STRING_LITERAL,
+    CHAR_LITERAL,
+    OPERATOR,
+    UNKNOWN,
+    ERROR
+};
+
+// Структура токена. lexeme указывает в исходный буфер и не владеет памятью
+struct Token {
+    TokenType type;
+    std::string_view lexeme;
+    SourceLoc loc; // смещение начала лексемы; строка и столбец - по LineTable
+    SymbolId id; // номер лексемы в общем пуле строк
+    TokenKind kind; // ключевое слово или оператор; TK_NONE для остальных
+
+    std::string typeToString() const {
+        switch (type) {
+            case KEYWORD: return "KEYWORD";
+            case IDENTIFIER: return "IDENTIFIER";
+            case NUMBER: return "NUMBER";
+            case FLOAT_NUMBER: return "FLOAT_NUMBER";
+            case STRING_LITERAL: return "STRING_LITERAL";
+            case CHAR_LITERAL: return "CHAR_LITERAL";
+            case OPERATOR: return "OPERATOR";
+            case ERROR: return "ERROR";
+            default: return "UNKNOWN";
+        }
+    }
+};
+
+// Классы символов для табличного лексера
+enum CharClass : unsigned char {
+    CC_OTHER,       // символ, не начинающий ни одного токена
+    CC_SPACE,
+    CC_NEWLINE,
+    CC_LETTER,      // буква или '_'
+    CC_DIGIT,
+    CC_DOT,
+    CC_QUOTE,       // '"'
+    CC_APOSTROPHE,  // '\''
+    CC_SLASH,
+    CC_BRACKET,     // '[' и ']' - оператор, но может продолжать идентификатор (int[])
+    CC_OPERATOR,
+    CC_UTF8         // байт >= 0x80: часть символа UTF-8, разбирается вне таблиц
+};
+
+// Число состояний не больше суммарной длины операторов плюс начальное
+constexpr size_t operatorDfaStates() {
+    size_t states = 1;
+    for (const LexiconEntry& entry : javaLexicon) {
+        if (isOperator(entry.kind)) {
+            states += entry.length;
+        }
+    }
+    return states;
+}
+
+constexpr size_t OPERATOR_DFA_STATES = operatorDfaStates();
+constexpr size_t OPERATOR_DFA_COLUMNS = 32;
+
+// Таблицы лексера: класс каждого из 256 байтов и автомат для операторов.
+// Состояния автомата - префиксы операторов, 0 - начальное состояние.
+// Переход в 0 означает, что оператор дальше не продолжается.
+// Допускающее состояние хранит вид оператора, остальные - TK_NONE.
+struct LexerTables {
+    CharClass charClass[256];
+    unsigned char operatorColumn[256];
+    unsigned char operatorNext[OPERATOR_DFA_STATES][OPERATOR_DFA_COLUMNS];
+    TokenKind operatorKind[OPERATOR_DFA_STATES];
+};
+
+constexpr LexerTables buildLexerTables() {
+    LexerTables tables{};
+    for (int c = 0; c < 256; c++) {
+        CharClass cls = CC_OTHER;
+        if (c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r') cls = CC_SPACE;
+        else if (c == '\n') cls = CC_NEWLINE;
+        else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') cls = CC_LETTER;
+        else if (c >= '0' && c <= '9') cls = CC_DIGIT;
+        else if (c == '.') cls = CC_DOT;
+        else if (c == '"') cls = CC_QUOTE;
+        else if (c == '\'') cls = CC_APOSTROPHE;
+        else if (c == '/') cls = CC_SLASH;
+        else if (c == '[' || c == ']') cls = CC_BRACKET;
+        else if (c >= 0x80) cls = CC_UTF8;
+        tables.charClass[c] = cls;
+    }
+
+    unsigned char columns = 1;
+    size_t states = 1;
+    for (const LexiconEntry& entry : javaLexicon) {
+        if (!isOperator(entry.kind)) {
+            continue;
+        }
+        size_t state = 0;
+        for (const char* p = entry.text; *p; p++) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            if (tables.operatorColumn[c] == 0) {
+                tables.operatorColumn[c] = columns++;
+            }
+            if (tables.charClass[c] == CC_OTHER) {
+                tables.charClass[c] = CC_OPERATOR;
+            }
+            unsigned char& next = tables.operatorNext[state][tables.operatorColumn[c]];
+            if (next == 0) {
+                next = static_cast<unsigned char>(states++);
+            }
+            state = next;
+        }
+        tables.operatorKind[state] = entry.kind;
+    }
+    return tables;
+}
+
+constexpr LexerTables lexerTables = buildLexerTables();
+
+// Размер блока, которым читается файл в потоковом режиме
+constexpr size_t STREAM_CHUNK_SIZE = 1 << 20;
+
+// Класс лексического анализатора
+class Lexer {
+public:
+    // Разбор нового файла: начала строк записываются в LineTable::global()
+    explicit Lexer(std::string_view sourceCode = std::string_view())
+        : source(sourceCode), pos(0), line(1), symbols(Interner::global()),
+          lines(LineTable::global()), scan(scanner()) {
+        lines.clear();
+    }
+
+    // Разбор хвоста sourceCode начиная с позиции begin - начала строки;
+    // номера лексем выдаёт пул pool, начала строк дописываются в lineTable
+    Lexer(std::string_view sourceCode, size_t begin, Interner& pool, LineTable& lineTable)
+        : source(sourceCode), pos(begin), line(1), symbols(pool), lines(lineTable), scan(scanner()) {}
+
+    // Основная функция для токенизации
+    std::vector<Token> tokenize() {
+        tokens.clear();
+        Token token;
+        while (nextToken(token)) {
+            tokens.push_back(token);
+        }
+        return std::move(tokens);
+    }
+
+    // Следующий готовый токен по запросу; false - вход закончился (или,
+    // в потоке, нужен следующий блок). Последний разобранный токен
+    // придерживается: следующее за ним число может забрать его знак.
+    bool nextToken(Token& token) {
+        Token fresh;
+        while (next(fresh)) {
+            bool ready = hasPending && !signMerged;
+            if (ready) {
+                token = pending;
+                tokenPosition = pendingPosition;
+            }
+            pending = fresh;
+            pendingPosition = freshPosition;
+            hasPending = true;
+            if (ready) {
+                return true;
+            }
+        }
+        if (lastChunk && hasPending) {
+            token = pending;
+            tokenPosition = pendingPosition;
+            hasPending = false;
+            return true;
+        }
+        return false;
+    }
+
+    // Потоковая токенизация: вход читается блоками по chunkSize байт, и
+    // каждый токен передаётся в sink(token, position), а не копится в
+    // векторе. Память ограничена буфером блока и самой длинной лексемой:
+    // строка и столбец считаются на ходу и не запоминаются в LineTable,
+    // лексемы не попадают в пул строк (id у токенов NO_SYMBOL) и указывают
+    // в буфер чтения, поэтому верны только до возврата из sink.
+    // Позиции токенов 32-битные, поэтому вход длиннее NO_LOC байт не
+    // разбирается: тогда возвращается false.
+    template <typename Sink>
+    bool tokenizeStream(std::istream& input, Sink&& sink, size_t chunkSize = STREAM_CHUNK_SIZE) {
+        std::vector<char> buffer;
+        size_t filled = 0;
+        pos = 0;
+        base = 0;
+        line = 1;
+        utf8CheckedFrom = SIZE_MAX;
+        hasPending = false;
+        streaming = true;
+        streamLine = 1;
+        streamLineStart = 0;
+        std::string pendingText;
+        do {
+            if (buffer.size() < filled + chunkSize) {
+                buffer.resize(filled + chunkSize);
+            }
+            input.read(buffer.data() + filled, static_cast<std::streamsize>(chunkSize));
+            size_t count = static_cast<size_t>(input.gcount());
+            filled += count;
+            lastChunk = count < chunkSize;
+            if (uint64_t(base) + filled >= NO_LOC) {
+                streaming = false;
+                return false;
+            }
+            source = std::string_view(buffer.data(), filled);
+
+            Token token;
+            while (nextToken(token)) {
+                sink(token, tokenPosition);
+            }
+
+            // Придержанный токен переживает сдвиг буфера только в копии
+            if (hasPending) {
+                pendingText.assign(pending.lexeme.data(), pending.lexeme.size());
+                pending.lexeme = pendingText;
+            }
+            // Сдвигаем недоразобранный хвост в начало буфера, сохраняя
+            // два предыдущих символа для проверки знака числа
+            size_t keep = pos < 2 ? 0 : pos - 2;
+            std::memmove(buffer.data(), buffer.data() + keep, filled - keep);
+            filled -= keep;
+            pos -= keep;
+            base += keep;
+            utf8CheckedFrom = SIZE_MAX; // конец буфера мог оборвать символ
+        } while (!lastChunk);
+        streaming = false;
+        return true;
+    }
+
+private:
+    // Сколько символов после конца лексемы может понадобиться для её разбора
+    static constexpr size_t STREAM_LOOKAHEAD = 4;
+
+    std::string_view source;
+    size_t pos;
+    size_t base = 0; // смещение source[0] от начала файла (в потоке)
+    int line;
+    std::vector<Token> tokens;
+    Interner& symbols; // Пул строк, выдающий ID токенов
+    LineTable& lines;  // Начала строк файла
+    const Scanner& scan;
+    bool lastChunk = true;   // source содержит конец входа
+    bool signMerged = false; // последнее число забрало знак предыдущего токена
+    Token pending{};          // разобранный, но ещё не выданный токен
+    bool hasPending = false;
+    // Потоковый режим: позиции считаются здесь, а не в LineTable
+    bool streaming = false;
+    int streamLine = 1;          // строка, в которой лежит source[pos]
+    size_t streamLineStart = 0;  // смещение её начала от начала файла
+    LineColumn freshPosition{};  // позиции токенов из next(), pending
+    LineColumn pendingPosition{}; // и последнего выданного nextToken()
+    LineColumn tokenPosition{};
+    size_t utf8CheckedFrom = SIZE_MAX; // откуда проверен UTF-8 буфера
+    size_t utf8Error = 0;              // первая ошибка UTF-8 после utf8CheckedFrom
+
+    // Разбирает следующий токен; false, если токенов в source больше нет.
+    // Пока source - не последний блок потока, лексема, подошедшая к концу
+    // буфера ближе STREAM_LOOKAHEAD, не выдаётся: позиция и номер строки
+    // откатываются к её началу до подгрузки следующего блока.
+    bool next(Token& token) {
+        const size_t length = source.length();
+        while (pos < length) {
+            size_t start = pos;
+            int startLine = line;
+            bool produced = true;
+            signMerged = false;
+            unsigned char currentChar = static_cast<unsigned char>(source[pos]);
+
+            switch (lexerTables.charClass[currentChar]) {
+                case CC_NEWLINE:
+                case CC_SPACE:
+                    // Пропускаем пробелы, считая переводы строк
+                    pos = scan.skipWhitespace(source.data(), pos, length, line);
+                    produced = false;
+                    break;
+                case CC_LETTER:
+                    token = consumeIdentifierOrKeyword();
+                    break;
+                case CC_DIGIT:
+                    token = consumeNumber();
+                    break;
+                case CC_DOT:
+                    if (pos + 1 < length && classOf(source[pos + 1]) == CC_DIGIT) {
+                        token = consumeNumber();
+                    } else {
+                        token = consumeOperator();
+                    }
+                    break;
+                case CC_QUOTE:
+                    token = consumeStringLiteral();
+                    break;
+                case CC_APOSTROPHE:
+                    token = consumeCharLiteral();
+                    break;
+                case CC_SLASH:
+                    if (pos + 1 < length && (source[pos + 1] == '/' || source[pos + 1] == '*')) {
+                        consumeComment(); // Игнорируем комментарии
+                        produced = false;
+                    } else {
+                        token = consumeOperator();
+                    }
+                    break;
+                case CC_BRACKET:
+                case CC_OPERATOR:
+                    token = consumeOperator();
+                    break;
+                case CC_UTF8:
+                    if (unicodeIdentifierLength(pos, true) != 0) {
+                        token = consumeIdentifierOrKeyword();
+                    } else {
+                        // Символ целиком (или один некорректный байт)
+                        size_t charLength = utf8CharLength(source.data(), pos, length);
+                        token = createToken(ERROR, source.substr(pos, charLength));
+                        pos += charLength;
+                    }
+                    break;
+                default:
+                    token = createToken(ERROR, source.substr(pos, 1));
+                    pos++;
+                    break;
+            }
+
+            if (!lastChunk && pos + STREAM_LOOKAHEAD > length) {
+                pos = start;
+                line = startLine;
+                signMerged = false;
+                return false;
+            }
+            if (produced && streaming) {
+                freshPosition = {streamLine, static_cast<int>(base + (token.lexeme.data() - source.data()) -
+                                                              streamLineStart) + 1};
+            }
+            if (line != startLine) {
+                recordLines(start);
+            }
+            if (produced) {
+                token.id = streaming ? NO_SYMBOL : symbols.intern(token.lexeme);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static CharClass classOf(char c) {
+        return lexerTables.charClass[static_cast<unsigned char>(c)];
+    }
+
+    static bool isIdentifierPart(char c) {
+        CharClass cls = classOf(c);
+        return cls == CC_LETTER || cls == CC_DIGIT || cls == CC_BRACKET;
+    }
+
+    // Длина символа вне ASCII в позиции at, если он может начинать (start)
+    // или продолжать идентификатор; иначе 0
+    size_t unicodeIdentifierLength(size_t at, bool start) const {
+        char32_t codePoint;
+        size_t length = decodeUtf8(source.data(), at, source.length(), codePoint);
+        if (length == 0) {
+            return 0;
+        }
+        bool allowed = start ? isUnicodeIdentifierStart(codePoint) : isUnicodeIdentifierPart(codePoint);
+        return allowed ? length : 0;
+    }
+
+    // Корректен ли UTF-8 в лексеме [start, pos). Буфер проверяется блоками
+    // вперёд до первой ошибки, результат служит следующим лексемам, пока
+    // они не уйдут за неё, поэтому каждый байт проверяется один раз
+    bool validUtf8(size_t start) {
+        if (start < utf8CheckedFrom || start > utf8Error) {
+            utf8CheckedFrom = start;
+            utf8Error = scan.validateUtf8(source.data(), start, source.length());
+        }
+        return utf8Error >= pos;
+    }
+
+    static bool isDigit(char c) {
+        return classOf(c) == CC_DIGIT;
+    }
+
+    static bool isSpace(char c) {
+        CharClass cls = classOf(c);
+        return cls == CC_SPACE || cls == CC_NEWLINE;
+    }
+
+    // Записывает начала строк после переводов строки, пройденных с позиции
+    // from. Вызывается, только если шаг изменил счётчик строк: перевод строки,
+    // проглоченный символьным литералом, лексер не считает, и таблица тоже.
+    // В потоке запоминается только начало последней строки.
+    void recordLines(size_t from) {
+        const char* data = source.data();
+        size_t end = std::min(pos, source.length());
+        while (from < end) {
+            const void* found = std::memchr(data + from, '\n', end - from);
+            if (!found) {
+                break;
+            }
+            from = static_cast<const char*>(found) - data + 1;
+            if (streaming) {
+                streamLine++;
+                streamLineStart = base + from;
+            } else {
+                lines.addLine(static_cast<SourceLoc>(base + from));
+            }
+        }
+    }
+
+    // Номер в пуле строк присваивается в next(), когда токен принят
+    Token createToken(TokenType type, std::string_view lexeme, TokenKind kind = TK_NONE) {
+        size_t start = lexeme.data() - source.data();
+        return {type, lexeme, static_cast<SourceLoc>(base + start), NO_SYMBOL, kind};
+    }
+
+    // ASCII проверяется по таблице, символы UTF-8 - декодированием
+    Token consumeIdentifierOrKeyword() {
+        size_t start = pos;
+        if (classOf(source[pos]) == CC_UTF8) {
+            pos += unicodeIdentifierLength(pos, true);
+        }
+        while (pos < source.length()) {
+            if (isIdentifierPart(source[pos])) {
+                pos++;
+                continue;
+            }
+            size_t length = classOf(source[pos]) == CC_UTF8 ? unicodeIdentifierLength(pos, false) : 0;
+            if (length == 0) {
+                break;
+            }
+            pos += length;
+        }
+        std::string_view word = source.substr(start, pos - start);
+        TokenKind kind = lookupLexicon(word);
+        return isKeyword(kind) ? createToken(KEYWORD, word, kind) : createToken(IDENTIFIER, word);
+    }
+
+    // '_' в числе допустим только между цифрами: за ним должна идти цифра
+    template <typename DigitTest>
+    bool underscoresBeforeDigit(size_t at, DigitTest isDigitAt) const {
+        while (at < source.length() && source[at] == '_') {
+            at++;
+        }
+        return at > 0 && source[at - 1] == '_' && at < source.length() && isDigitAt(at);
+    }
+
+    Token consumeNumber() {
+        size_t start = pos;
+        bool isFloat = false;
+
+        if (pos > 0 && (source[pos - 1] == '-' || source[pos - 1] == '+') && 
+            (pos - 1 == 0 || isSpace(source[pos - 2]) || source[pos - 2] == '=')) {
+            signMerged = true;
+            start = pos - 1;
+        }
+
+        // 0x1F и 0b101: цифры нужной системы и '_' между ними
+        if (source[pos] == '0' && pos + 1 < source.length() &&
+            (source[pos + 1] == 'x' || source[pos + 1] == 'X' ||
+             source[pos + 1] == 'b' || source[pos + 1] == 'B')) {
+            bool hex = source[pos + 1] == 'x' || source[pos + 1] == 'X';
+            pos += 2;
+            size_t digits = pos;
+            auto isBaseDigit = [this, hex](size_t at) {
+                char c = source[at];
+                return hex ? isDigit(c) || static_cast<unsigned>((c | 0x20) - 'a') < 6 : c == '0' || c == '1';
+            };
+            while (pos < source.length() &&
+                   (isBaseDigit(pos) || (pos > digits && underscoresBeforeDigit(pos, isBaseDigit)))) {
+                pos++;
+            }
+            if (pos == digits) {
+                return createToken(ERROR, source.substr(start, pos - start));
+            }
+            if (pos < source.length() && (source[pos] == 'L' || source[pos] == 'l')) {
+                pos++;
+            }
+            return createToken(NUMBER, source.substr(start, pos - start));
+        }
+
+        auto isDecimalDigit = [this](size_t at) { return isDigit(source[at]); };
+        while (pos < source.length() && (isDigit(source[pos]) || source[pos] == '.' ||
+               (pos > start && (isDigit(source[pos - 1]) || source[pos - 1] == '_') &&
+                underscoresBeforeDigit(pos, isDecimalDigit)))) {
+            if (source[pos] == '.') {
+                if (isFloat) {
+                    return createToken(ERROR, source.substr(start, pos - start));
+                }
+                isFloat = true;
+            }
+            pos++;
+        }
+
+        if (pos < source.length() && (source[pos] == 'e' || source[pos] == 'E')) {
+            isFloat = true;
+            pos++;
+            if (pos < source.length() && (source[pos] == '+' || source[pos] == '-')) {
+                pos++;
+            }
+            if (pos >= source.length() || !isDigit(source[pos])) {
+                return createToken(ERROR, source.substr(start, pos - start));
+            }
+            while (pos < source.length() && isDigit(source[pos])) {
+                pos++;
+            }
+        }
+
+        if (pos < source.length() && (source[pos] == 'f' || source[pos] == 'F' || source[pos] == 'd' || source[pos] == 'D')) {
+            isFloat = true;
+            pos++;
+        }
+        else if (!isFloat && pos < source.length() && (source[pos] == 'L' || source[pos] == 'l')) {
+            pos++;
+        }
+
+        return createToken(isFloat ? FLOAT_NUMBER : NUMBER, source.substr(start, pos - start));
+    }
+
+    Token consumeStringLiteral() {
+        size_t start = pos;
+        pos++;
+        while (true) {
+            pos = scan.findQuoteOrEscape(source.data(), pos, source.length(), line);
+            if (pos >= source.length() || source[pos] == '"') {
+                break;
+            }
+            if (pos + 1 < source.length()) {
+                if (source[pos + 1] == '\n') {
+                    line++;
+                }
+                pos += 2; // Экранированный символ
+            } else {
+                pos++;
+            }
+        }
+        if (pos < source.length() && source[pos] == '"') {
+            pos++;
+            return createToken(validUtf8(start) ? STRING_LITERAL : ERROR, source.substr(start, pos - start));
+        }
+        return createToken(ERROR, source.substr(start, pos - start));
+    }
+
+    Token consumeCharLiteral() {
+        size_t start = pos;
+        pos++;
+        if (pos < source.length() && source[pos] == '\\') {
+            pos += 2;
+        } else if (pos < source.length()) {
+            pos += utf8CharLength(source.data(), pos, source.length());
+        } else {
+            pos++;
+        }
+        if (pos < source.length() && source[pos] == '\'') {
+            pos++;
+            return createToken(validUtf8(start) ? CHAR_LITERAL : ERROR, source.substr(start, pos - start));
+        }
+        return createToken(ERROR, source.substr(start, pos - start));
+    }
+
+    void consumeComment() {
+        if (source[pos + 1] == '/') {
+            pos = scan.findLineEnd(source.data(), pos + 2, source.length());
+        } else if (source[pos + 1] == '*') {
+            size_t end = scan.findCommentEnd(source.data(), pos + 2, source.length(), line);
+            if (end < source.length()) {
+                pos = end + 2;
+            } else if (pos + 2 < source.length()) {
+                // Незакрытый комментарий: последний символ разбирается как обычно
+                pos = source.length() - 1;
+            } else {
+                pos += 2;
+            }
+        }
+    }
+
+    // Самый длинный оператор по таблице переходов автомата
+    Token consumeOperator() {
+        size_t start = pos;
+        size_t end = pos;
+        size_t state = 0;
+        TokenKind kind = TK_NONE;
+        while (pos < source.length()) {
+            unsigned char column = lexerTables.operatorColumn[static_cast<unsigned char>(source[pos])];
+            state = lexerTables.operatorNext[state][column];
+            if (state == 0) {
+                break;
+            }
+            pos++;
+            if (lexerTables.operatorKind[state] != TK_NONE) {
+                kind = lexerTables.operatorKind[state];
+                end = pos;
+            }
+        }
+        pos = end;
+        return createToken(OPERATOR, source.substr(start, end - start), kind);
+    }
+};
+
+// Последовательный предпросмотр для параллельного разбора. Повторяет правила
+// лексера для строк, символьных литералов и комментариев и для каждой из
+// parts - 1 равных долей буфера находит ближайшее начало строки, которое
+// лежит вне них: с него разбор можно начать независимо от предыдущего текста.
+inline std::vector<size_t> findRestartPoints(std::string_view source, size_t parts) {
+    const Scanner& scan = scanner();
+    const char* data = source.data();
+    const size_t length = source.length();
+    std::vector<size_t> points;
+    size_t part = 1;
+    size_t target = length / parts;
+    size_t pos = 0;
+    int newlines = 0; // сканерам нужен счётчик строк, здесь он не используется
+    while (pos < length && part < parts) {
+        char c = data[pos];
+        if (c == '\n') {
+            pos++;
+            if (pos >= target && pos < length) {
+                points.push_back(pos);
+                while (part < parts && target <= pos) {
+                    part++;
+                    target = length / parts * part;
+                }
+            }
+        } else if (c == '"') {
+            pos++;
+            while (true) {
+                pos = scan.findQuoteOrEscape(data, pos, length, newlines);
+                if (pos >= length || data[pos] == '"') {
+                    break;
+                }
+                pos += pos + 1 < length ? 2 : 1;
+            }
+            pos++;
+        } else if (c == '\'') {
+            pos++;
+            if (pos < length) {
+                pos += data[pos] == '\\' ? 2 : utf8CharLength(data, pos, length);
+            } else {
+                pos++;
+            }
+            if (pos < length && data[pos] == '\'') {
+                pos++;
+            }
+        } else if (c == '/' && pos + 1 < length && data[pos + 1] == '/') {
+            pos = scan.findLineEnd(data, pos + 2, length);
+        } else if (c == '/' && pos + 1 < length && data[pos + 1] == '*') {
+            size_t end = scan.findCommentEnd(data, pos + 2, length, newlines);
+            if (end >= length) {
+                break; // Незакрытый комментарий тянется до конца файла
+            }
+            pos = end + 2;
+        } else {
+            pos++;
+        }
+    }
+    return points;
+}
+
+// Минимальный размер доли, ради которой стоит запускать отдельный поток
+constexpr size_t PARALLEL_MIN_SLICE = 256 * 1024;
+
+// Параллельная токенизация: буфер делится на доли по точкам перезапуска,
+// каждая доля разбирается в своём потоке со своим пулом строк и своей
+// таблицей строк. При слиянии локальные пулы переносятся в общий по порядку
+// долей, поэтому номера лексем и весь результат совпадают с
+// последовательным разбором; таблицы строк склеиваются в LineTable::global().
+inline std::vector<Token> tokenizeParallel(std::string_view source, unsigned threadCount) {
+    size_t parts = std::max<size_t>(1, std::min<size_t>(threadCount, source.length() / PARALLEL_MIN_SLICE));
+    std::vector<size_t> starts = {0};
+    for (size_t point : findRestartPoints(source, parts)) {
+        starts.push_back(point);
+    }
+    size_t slices = starts.size();
+
+    std::vector<std::vector<Token>> results(slices);
+    std::vector<std::unique_ptr<Interner>> pools(slices);
+    std::vector<LineTable> lineTables(slices);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < slices; i++) {
+        pools[i].reset(new Interner());
+        size_t end = i + 1 < slices ? starts[i + 1] : source.length();
+        auto work = [&, i, end]() {
+            Lexer lexer(source.substr(0, end), starts[i], *pools[i], lineTables[i]);
+            results[i] = lexer.tokenize();
+        };
+        if (i + 1 < slices) {
+            workers.emplace_back(work);
+        } else {
+            work(); // Последняя доля - в текущем потоке
+        }
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    Interner& symbols = Interner::global();
+    LineTable& lines = LineTable::global();
+    lines.clear();
+    size_t total = 0;
+    for (const std::vector<Token>& slice : results) {
+        total += slice.size();
+    }
+    std::vector<Token> tokens;
+    tokens.reserve(total);
+    std::vector<SymbolId> remap;
+    for (size_t i = 0; i < slices; i++) {
+        remap.assign(pools[i]->size() + 1, NO_SYMBOL);
+        for (SymbolId id = 1; id < remap.size(); id++) {
+            remap[id] = symbols.intern(pools[i]->name(id));
+        }
+        for (Token& token : results[i]) {
+            token.id = remap[token.id];
+            tokens.push_back(token);
+        }
+        std::vector<Token>().swap(results[i]);
+        lines.append(lineTables[i]);
+    }
+    return tokens;
+}
+
+// Текстовая запись токена для отладки (формат старого output.txt)
+inline void writeToken(std::ostream& output, const Token& token, int line) {
+    output << "Token: " << token.typeToString()
+           << " Lexem: @" << token.lexeme << "@"
+           << " Line: " << line
+           << " Id: " << token.id << "\n";
+}
+
+inline void writeToken(std::ostream& output, const Token& token, const LineTable& lines) {
+    writeToken(output, token, lines.resolve(token.loc).line);
+}
+
+#endif // LEXER_HPP
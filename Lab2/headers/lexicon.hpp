@@ -0,0 +1,184 @@
+#ifndef LEXICON_HPP
+#define LEXICON_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Вид лексемы из словаря языка: ключевое слово или оператор.
+// TK_NONE означает, что текст в словаре отсутствует (идентификатор и т.п.).
+enum TokenKind : unsigned char {
+    TK_NONE,
+
+    // Ключевые слова
+    KW_ABSTRACT, KW_ASSERT, KW_BOOLEAN, KW_BREAK, KW_BYTE, KW_CASE, KW_CATCH, KW_CHAR,
+    KW_CLASS, KW_CONST, KW_CONTINUE, KW_DEFAULT, KW_DO, KW_DOUBLE, KW_DOUBLE_ARRAY, KW_ELSE,
+    KW_ENUM, KW_EXTENDS, KW_FINAL, KW_FINALLY, KW_FLOAT, KW_FLOAT_ARRAY, KW_FOR, KW_GOTO,
+    KW_IF, KW_IMPLEMENTS, KW_IMPORT, KW_INSTANCEOF, KW_INT, KW_INT_ARRAY, KW_INTERFACE, KW_LONG,
+    KW_LONG_ARRAY, KW_NATIVE, KW_NEW, KW_NULL, KW_PACKAGE, KW_PRIVATE, KW_PROTECTED, KW_PUBLIC,
+    KW_RETURN, KW_SHORT, KW_SHORT_ARRAY, KW_STATIC, KW_STRICTFP, KW_SUPER, KW_SWITCH,
+    KW_SYNCHRONIZED, KW_THIS, KW_THROW, KW_THROWS, KW_TRANSIENT, KW_TRY, KW_VOID, KW_VOLATILE,
+    KW_WHILE, KW_TRUE, KW_FALSE, KW_STRING, KW_STRING_ARRAY, KW_ARRAYLIST, KW_HASHMAP, KW_HASHSET,
+
+    // Операторы и разделители
+    PLUS, MINUS, STAR, SLASH, PERCENT, PLUS_PLUS, MINUS_MINUS, EQ_EQ, NOT_EQ, GREATER, LESS,
+    GREATER_EQ, LESS_EQ, AND_AND, OR_OR, NOT, ASSIGN, PLUS_ASSIGN, MINUS_ASSIGN, STAR_ASSIGN,
+    SLASH_ASSIGN, PERCENT_ASSIGN, AMP, PIPE, CARET, TILDE, SHIFT_LEFT, SHIFT_RIGHT,
+    UNSIGNED_SHIFT_RIGHT, QUESTION, COLON, COLON_COLON, DOT, COMMA, SEMICOLON, LPAREN, RPAREN,
+    LBRACE, RBRACE, LBRACKET, RBRACKET,
+
+    TOKEN_KIND_COUNT
+};
+
+struct LexiconEntry {
+    const char* text;
+    unsigned char length;
+    TokenKind kind;
+};
+
+// Словарь в порядке перечисления TokenKind: javaLexicon[kind - 1].kind == kind
+constexpr LexiconEntry javaLexicon[] = {
+    {"abstract", 8, KW_ABSTRACT}, {"assert", 6, KW_ASSERT}, {"boolean", 7, KW_BOOLEAN},
+    {"break", 5, KW_BREAK}, {"byte", 4, KW_BYTE}, {"case", 4, KW_CASE}, {"catch", 5, KW_CATCH},
+    {"char", 4, KW_CHAR}, {"class", 5, KW_CLASS}, {"const", 5, KW_CONST},
+    {"continue", 8, KW_CONTINUE}, {"default", 7, KW_DEFAULT}, {"do", 2, KW_DO},
+    {"double", 6, KW_DOUBLE}, {"double[]", 8, KW_DOUBLE_ARRAY}, {"else", 4, KW_ELSE},
+    {"enum", 4, KW_ENUM}, {"extends", 7, KW_EXTENDS}, {"final", 5, KW_FINAL},
+    {"finally", 7, KW_FINALLY}, {"float", 5, KW_FLOAT}, {"float[]", 7, KW_FLOAT_ARRAY},
+    {"for", 3, KW_FOR}, {"goto", 4, KW_GOTO}, {"if", 2, KW_IF}, {"implements", 10, KW_IMPLEMENTS},
+    {"import", 6, KW_IMPORT}, {"instanceof", 10, KW_INSTANCEOF}, {"int", 3, KW_INT},
+    {"int[]", 5, KW_INT_ARRAY}, {"interface", 9, KW_INTERFACE}, {"long", 4, KW_LONG},
+    {"long[]", 6, KW_LONG_ARRAY}, {"native", 6, KW_NATIVE}, {"new", 3, KW_NEW},
+    {"null", 4, KW_NULL}, {"package", 7, KW_PACKAGE}, {"private", 7, KW_PRIVATE},
+    {"protected", 9, KW_PROTECTED}, {"public", 6, KW_PUBLIC}, {"return", 6, KW_RETURN},
+    {"short", 5, KW_SHORT}, {"short[]", 7, KW_SHORT_ARRAY}, {"static", 6, KW_STATIC},
+    {"strictfp", 8, KW_STRICTFP}, {"super", 5, KW_SUPER}, {"switch", 6, KW_SWITCH},
+    {"synchronized", 12, KW_SYNCHRONIZED}, {"this", 4, KW_THIS}, {"throw", 5, KW_THROW},
+    {"throws", 6, KW_THROWS}, {"transient", 9, KW_TRANSIENT}, {"try", 3, KW_TRY},
+    {"void", 4, KW_VOID}, {"volatile", 8, KW_VOLATILE}, {"while", 5, KW_WHILE},
+    {"true", 4, KW_TRUE}, {"false", 5, KW_FALSE}, {"String", 6, KW_STRING},
+    {"String[]", 8, KW_STRING_ARRAY}, {"ArrayList", 9, KW_ARRAYLIST}, {"HashMap", 7, KW_HASHMAP},
+    {"HashSet", 7, KW_HASHSET},
+
+    {"+", 1, PLUS}, {"-", 1, MINUS}, {"*", 1, STAR}, {"/", 1, SLASH}, {"%", 1, PERCENT},
+    {"++", 2, PLUS_PLUS}, {"--", 2, MINUS_MINUS}, {"==", 2, EQ_EQ}, {"!=", 2, NOT_EQ},
+    {">", 1, GREATER}, {"<", 1, LESS}, {">=", 2, GREATER_EQ}, {"<=", 2, LESS_EQ},
+    {"&&", 2, AND_AND}, {"||", 2, OR_OR}, {"!", 1, NOT}, {"=", 1, ASSIGN},
+    {"+=", 2, PLUS_ASSIGN}, {"-=", 2, MINUS_ASSIGN}, {"*=", 2, STAR_ASSIGN},
+    {"/=", 2, SLASH_ASSIGN}, {"%=", 2, PERCENT_ASSIGN}, {"&", 1, AMP}, {"|", 1, PIPE},
+    {"^", 1, CARET}, {"~", 1, TILDE}, {"<<", 2, SHIFT_LEFT}, {">>", 2, SHIFT_RIGHT},
+    {">>>", 3, UNSIGNED_SHIFT_RIGHT}, {"?", 1, QUESTION}, {":", 1, COLON},
+    {"::", 2, COLON_COLON}, {".", 1, DOT}, {",", 1, COMMA}, {";", 1, SEMICOLON},
+    {"(", 1, LPAREN}, {")", 1, RPAREN}, {"{", 1, LBRACE}, {"}", 1, RBRACE},
+    {"[", 1, LBRACKET}, {"]", 1, RBRACKET}
+};
+
+constexpr size_t LEXICON_SIZE = sizeof(javaLexicon) / sizeof(javaLexicon[0]);
+constexpr size_t LEXICON_MAX_LENGTH = 12; // "synchronized"
+
+constexpr bool isKeyword(TokenKind kind) {
+    return kind >= KW_ABSTRACT && kind <= KW_HASHSET;
+}
+
+constexpr bool isOperator(TokenKind kind) {
+    return kind >= PLUS && kind <= RBRACKET;
+}
+
+// Текст лексемы по её виду; для TK_NONE - пустая строка
+constexpr std::string_view kindText(TokenKind kind) {
+    return kind == TK_NONE || kind >= TOKEN_KIND_COUNT
+        ? std::string_view()
+        : std::string_view(javaLexicon[kind - 1].text, javaLexicon[kind - 1].length);
+}
+
+namespace lexicon_detail {
+
+constexpr unsigned PERFECT_HASH_BITS = 11;
+constexpr size_t PERFECT_HASH_SLOTS = size_t(1) << PERFECT_HASH_BITS;
+
+// Ключ хеша: длина, первые два, средний и последний байты.
+// Для словаря этих байтов достаточно, чтобы различить все лексемы.
+constexpr uint64_t hashKey(const char* text, size_t length) {
+    uint64_t first = static_cast<unsigned char>(text[0]);
+    uint64_t second = length > 1 ? static_cast<unsigned char>(text[1]) : 0;
+    uint64_t middle = static_cast<unsigned char>(text[length / 2]);
+    uint64_t last = static_cast<unsigned char>(text[length - 1]);
+    return first | (second << 8) | (middle << 16) | (last << 24) | (uint64_t(length) << 32);
+}
+
+constexpr size_t slotOf(uint64_t key, uint64_t seed) {
+    return static_cast<size_t>((key * seed) >> (64 - PERFECT_HASH_BITS));
+}
+
+// Слот хранит номер записи словаря + 1 (т.е. сам TokenKind), 0 - пусто
+struct PerfectHashTable {
+    uint64_t seed;
+    unsigned char slots[PERFECT_HASH_SLOTS];
+};
+
+// Перебирает множители, пока все лексемы не попадут в разные слоты
+constexpr PerfectHashTable buildPerfectHash() {
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        uint64_t seed = state; // splitmix64
+        seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+        seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+        seed = (seed ^ (seed >> 31)) | 1;
+        state += 0x9E3779B97F4A7C15ull;
+
+        PerfectHashTable table{};
+        table.seed = seed;
+        bool collision = false;
+        for (size_t i = 0; i < LEXICON_SIZE && !collision; i++) {
+            size_t slot = slotOf(hashKey(javaLexicon[i].text, javaLexicon[i].length), seed);
+            if (table.slots[slot] != 0) {
+                collision = true;
+            } else {
+                table.slots[slot] = javaLexicon[i].kind;
+            }
+        }
+        if (!collision) {
+            return table;
+        }
+    }
+    return PerfectHashTable{};
+}
+
+constexpr bool lexiconIsOrdered() {
+    for (size_t i = 0; i < LEXICON_SIZE; i++) {
+        if (javaLexicon[i].kind != i + 1 ||
+            std::string_view(javaLexicon[i].text).size() != javaLexicon[i].length ||
+            javaLexicon[i].length > LEXICON_MAX_LENGTH) {
+            return false;
+        }
+    }
+    return LEXICON_SIZE + 1 == TOKEN_KIND_COUNT;
+}
+
+constexpr PerfectHashTable perfectHash = buildPerfectHash();
+
+static_assert(lexiconIsOrdered(), "javaLexicon должен совпадать с перечислением TokenKind");
+static_assert(perfectHash.seed != 0, "не найден множитель для совершенного хеша словаря");
+
+} // namespace lexicon_detail
+
+// Вид лексемы по тексту: один хеш и одно сравнение памяти
+inline TokenKind lookupLexicon(std::string_view text) {
+    using namespace lexicon_detail;
+    if (text.empty() || text.size() > LEXICON_MAX_LENGTH) {
+        return TK_NONE;
+    }
+    TokenKind kind = static_cast<TokenKind>(
+        perfectHash.slots[slotOf(hashKey(text.data(), text.size()), perfectHash.seed)]);
+    if (kind == TK_NONE) {
+        return TK_NONE;
+    }
+    const LexiconEntry& entry = javaLexicon[kind - 1];
+    if (entry.length != text.size() || std::memcmp(entry.text, text.data(), text.size()) != 0) {
+        return TK_NONE;
+    }
+    return kind;
+}
+
+#endif // LEXICON_HPP
@@ -0,0 +1,431 @@
+#ifndef SCANNER_HPP
+#define SCANNER_HPP
+
+#include <cstddef>
+#include "unicode.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+// Быстрые сканеры для лексера: пробелы, комментарии, строковые литералы и
+// проверка UTF-8. Каждая функция просматривает диапазон [pos, end) буфера
+// data, возвращает позицию найденного байта (или end, если ничего не
+// найдено) и прибавляет к newlines число символов '\n', через которые прошла.
+// Реализация (AVX2, SSE2 или скалярная) выбирается один раз при запуске.
+struct Scanner {
+    // Первый символ, не являющийся пробельным
+    size_t (*skipWhitespace)(const char* data, size_t pos, size_t end, int& newlines);
+    // Конец однострочного комментария: первый '\n'
+    size_t (*findLineEnd)(const char* data, size_t pos, size_t end);
+    // Начало "*/"; переводы строк считаются до end - 1, как в исходном цикле лексера
+    size_t (*findCommentEnd)(const char* data, size_t pos, size_t end, int& newlines);
+    // Первый '"' или '\\' внутри строкового литерала
+    size_t (*findQuoteOrEscape)(const char* data, size_t pos, size_t end, int& newlines);
+    // Первый байт некорректной последовательности UTF-8; pos - начало символа
+    size_t (*validateUtf8)(const char* data, size_t pos, size_t end);
+};
+
+namespace scanner_detail {
+
+inline bool isSpace(char c) {
+    return c == ' ' || (static_cast<unsigned char>(c) - '\t') <= ('\r' - '\t');
+}
+
+inline size_t skipWhitespaceScalar(const char* data, size_t pos, size_t end, int& newlines) {
+    while (pos < end && isSpace(data[pos])) {
+        if (data[pos] == '\n') {
+            newlines++;
+        }
+        pos++;
+    }
+    return pos;
+}
+
+inline size_t findLineEndScalar(const char* data, size_t pos, size_t end) {
+    while (pos < end && data[pos] != '\n') {
+        pos++;
+    }
+    return pos;
+}
+
+inline size_t findCommentEndScalar(const char* data, size_t pos, size_t end, int& newlines) {
+    while (pos + 1 < end) {
+        if (data[pos] == '*' && data[pos + 1] == '/') {
+            return pos;
+        }
+        if (data[pos] == '\n') {
+            newlines++;
+        }
+        pos++;
+    }
+    return end;
+}
+
+inline size_t findQuoteOrEscapeScalar(const char* data, size_t pos, size_t end, int& newlines) {
+    while (pos < end && data[pos] != '"' && data[pos] != '\\') {
+        if (data[pos] == '\n') {
+            newlines++;
+        }
+        pos++;
+    }
+    return pos;
+}
+
+inline size_t validateUtf8Scalar(const char* data, size_t pos, size_t end) {
+    char32_t codePoint;
+    while (pos < end) {
+        if (static_cast<unsigned char>(data[pos]) < 0x80) {
+            pos++;
+            continue;
+        }
+        size_t length = decodeUtf8(data, pos, end, codePoint);
+        if (length == 0) {
+            return pos;
+        }
+        pos += length;
+    }
+    return end;
+}
+
+// Число переводов строк в маске до позиции index
+inline int countBefore(unsigned mask, unsigned index) {
+    return __builtin_popcount(mask & ((1u << index) - 1));
+}
+
+#ifdef SCANNER_X86
+
+__attribute__((target("sse2")))
+inline size_t skipWhitespaceSse2(const char* data, size_t pos, size_t end, int& newlines) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i controlRange = _mm_set1_epi8('\r' - '\t');
+    while (pos + 16 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i shifted = _mm_sub_epi8(v, tab);
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, controlRange), shifted);
+        unsigned spaces = _mm_movemask_epi8(_mm_or_si128(control, _mm_cmpeq_epi8(v, space)));
+        unsigned lines = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+        if (spaces != 0xFFFFu) {
+            unsigned index = __builtin_ctz(~spaces);
+            newlines += countBefore(lines, index);
+            return pos + index;
+        }
+        newlines += __builtin_popcount(lines);
+        pos += 16;
+    }
+    return skipWhitespaceScalar(data, pos, end, newlines);
+}
+
+__attribute__((target("sse2")))
+inline size_t findLineEndSse2(const char* data, size_t pos, size_t end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (pos + 16 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned lines = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+        if (lines) {
+            return pos + __builtin_ctz(lines);
+        }
+        pos += 16;
+    }
+    return findLineEndScalar(data, pos, end);
+}
+
+__attribute__((target("sse2")))
+inline size_t findCommentEndSse2(const char* data, size_t pos, size_t end, int& newlines) {
+    const __m128i star = _mm_set1_epi8('*');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (pos + 17 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 1));
+        unsigned closes = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v, star), _mm_cmpeq_epi8(next, slash)));
+        unsigned lines = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+        if (closes) {
+            unsigned index = __builtin_ctz(closes);
+            newlines += countBefore(lines, index);
+            return pos + index;
+        }
+        newlines += __builtin_popcount(lines);
+        pos += 16;
+    }
+    return findCommentEndScalar(data, pos, end, newlines);
+}
+
+__attribute__((target("sse2")))
+inline size_t findQuoteOrEscapeSse2(const char* data, size_t pos, size_t end, int& newlines) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (pos + 16 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned stops = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+        unsigned lines = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+        if (stops) {
+            unsigned index = __builtin_ctz(stops);
+            newlines += countBefore(lines, index);
+            return pos + index;
+        }
+        newlines += __builtin_popcount(lines);
+        pos += 16;
+    }
+    return findQuoteOrEscapeScalar(data, pos, end, newlines);
+}
+
+// ASCII пропускается по 16 байт, многобайтовые символы проверяются по одному
+__attribute__((target("sse2")))
+inline size_t validateUtf8Sse2(const char* data, size_t pos, size_t end) {
+    char32_t codePoint;
+    while (pos + 16 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned high = _mm_movemask_epi8(v);
+        if (high == 0) {
+            pos += 16;
+            continue;
+        }
+        pos += __builtin_ctz(high);
+        size_t length = decodeUtf8(data, pos, end, codePoint);
+        if (length == 0) {
+            return pos;
+        }
+        pos += length;
+    }
+    return validateUtf8Scalar(data, pos, end);
+}
+
+__attribute__((target("avx2")))
+inline size_t skipWhitespaceAvx2(const char* data, size_t pos, size_t end, int& newlines) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i controlRange = _mm256_set1_epi8('\r' - '\t');
+    while (pos + 32 <= end) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i shifted = _mm256_sub_epi8(v, tab);
+        __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, controlRange), shifted);
+        unsigned spaces = _mm256_movemask_epi8(_mm256_or_si256(control, _mm256_cmpeq_epi8(v, space)));
+        unsigned lines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+        if (spaces != 0xFFFFFFFFu) {
+            unsigned index = __builtin_ctz(~spaces);
+            newlines += countBefore(lines, index);
+            return pos + index;
+        }
+        newlines += __builtin_popcount(lines);
+        pos += 32;
+    }
+    return skipWhitespaceSse2(data, pos, end, newlines);
+}
+
+__attribute__((target("avx2")))
+inline size_t findLineEndAvx2(const char* data, size_t pos, size_t end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    while (pos + 32 <= end) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        unsigned lines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+        if (lines) {
+            return pos + __builtin_ctz(lines);
+        }
+        pos += 32;
+    }
+    return findLineEndSse2(data, pos, end);
+}
+
+__attribute__((target("avx2")))
+inline size_t findCommentEndAvx2(const char* data, size_t pos, size_t end, int& newlines) {
+    const __m256i star = _mm256_set1_epi8('*');
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    while (pos + 33 <= end) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 1));
+        unsigned closes = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(v, star), _mm256_cmpeq_epi8(next, slash)));
+        unsigned lines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+        if (closes) {
+            unsigned index = __builtin_ctz(closes);
+            newlines += countBefore(lines, index);
+            return pos + index;
+        }
+        newlines += __builtin_popcount(lines);
+        pos += 32;
+    }
+    return findCommentEndSse2(data, pos, end, newlines);
+}
+
+__attribute__((target("avx2")))
+inline size_t findQuoteOrEscapeAvx2(const char* data, size_t pos, size_t end, int& newlines) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    while (pos + 32 <= end) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        unsigned stops = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)));
+        unsigned lines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+        if (stops) {
+            unsigned index = __builtin_ctz(stops);
+            newlines += countBefore(lines, index);
+            return pos + index;
+        }
+        newlines += __builtin_popcount(lines);
+        pos += 32;
+    }
+    return findQuoteOrEscapeSse2(data, pos, end, newlines);
+}
+
+// Проверка UTF-8 блоками по 32 байта по таблицам (Keiser, Lemire,
+// "Validating UTF-8 In Less Than One Instruction Per Byte"). Ошибки в
+// первых двух байтах последовательности ищутся тремя выборками из таблиц
+// по полубайтам, обязательные третий и четвёртый байты - по сдвинутым
+// блокам. Блок из одного ASCII пропускается, если предыдущий не оборвал
+// последовательность.
+namespace utf8_avx2 {
+
+constexpr char TOO_SHORT = 1 << 0;      // 11______ 0_______
+constexpr char TOO_LONG = 1 << 1;       // 0_______ 10______
+constexpr char OVERLONG_3 = 1 << 2;     // 11100000 100_____
+constexpr char TOO_LARGE = 1 << 3;      // 11110100 1001____
+constexpr char SURROGATE = 1 << 4;      // 11101101 101_____
+constexpr char OVERLONG_2 = 1 << 5;     // 1100000_ 10______
+constexpr char TOO_LARGE_1000 = 1 << 6; // 11110101 1000____
+constexpr char OVERLONG_4 = 1 << 6;     // 11110000 1000____
+constexpr char TWO_CONTS = char(1 << 7); // 10______ 10______
+constexpr char CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+// Блок, сдвинутый на N байт назад с хвостом предыдущего блока
+template <int N>
+__attribute__((target("avx2")))
+inline __m256i previousBytes(__m256i input, __m256i previous) {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - N);
+}
+
+__attribute__((target("avx2")))
+inline __m256i highNibbles(__m256i v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+__attribute__((target("avx2")))
+inline __m256i checkBlock(__m256i input, __m256i previous) {
+    const __m256i byte1HighTable = _mm256_setr_epi8(
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+    const char large = CARRY | TOO_LARGE | TOO_LARGE_1000;
+    const __m256i byte1LowTable = _mm256_setr_epi8(
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+        CARRY | TOO_LARGE, large, large, large, large, large, large, large, large,
+        large | SURROGATE, large, large,
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+        CARRY | TOO_LARGE, large, large, large, large, large, large, large, large,
+        large | SURROGATE, large, large);
+    const char cont80 = TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4;
+    const char cont90 = TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE;
+    const char contA0 = TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE;
+    const __m256i byte2HighTable = _mm256_setr_epi8(
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        cont80, cont90, contA0, contA0, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        cont80, cont90, contA0, contA0, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    __m256i prev1 = previousBytes<1>(input, previous);
+    __m256i byte1High = _mm256_shuffle_epi8(byte1HighTable, highNibbles(prev1));
+    __m256i byte1Low = _mm256_shuffle_epi8(byte1LowTable, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+    __m256i byte2High = _mm256_shuffle_epi8(byte2HighTable, highNibbles(input));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+    // Старший бит: байт обязан быть третьим или четвёртым байтом символа
+    __m256i prev2 = previousBytes<2>(input, previous);
+    __m256i prev3 = previousBytes<3>(input, previous);
+    __m256i thirdByte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(char(0xE0 - 0x80)));
+    __m256i fourthByte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(char(0xF0 - 0x80)));
+    __m256i required = _mm256_and_si256(_mm256_or_si256(thirdByte, fourthByte), _mm256_set1_epi8(char(0x80)));
+    return _mm256_xor_si256(required, special);
+}
+
+// Ненулевые байты - последовательность, начатая в конце блока, не закончена
+__attribute__((target("avx2")))
+inline __m256i incompleteTail(__m256i input) {
+    const __m256i maximum = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+    return _mm256_subs_epu8(input, maximum);
+}
+
+} // namespace utf8_avx2
+
+__attribute__((target("avx2")))
+inline size_t validateUtf8Avx2(const char* data, size_t pos, size_t end) {
+    const size_t start = pos;
+    __m256i previous = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    bool tail = false;
+    while (!tail) {
+        __m256i input;
+        if (pos + 32 <= end) {
+            input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        } else {
+            // Последний неполный блок дополняется нулями: оборванная в конце
+            // последовательность видна как TOO_SHORT
+            alignas(32) char padded[32] = {};
+            for (size_t i = pos; i < end; i++) {
+                padded[i - pos] = data[i];
+            }
+            input = _mm256_load_si256(reinterpret_cast<const __m256i*>(padded));
+            tail = true;
+        }
+        if (_mm256_movemask_epi8(input) == 0) {
+            error = _mm256_or_si256(error, incomplete);
+        } else {
+            error = _mm256_or_si256(error, utf8_avx2::checkBlock(input, previous));
+            incomplete = utf8_avx2::incompleteTail(input);
+        }
+        if (!_mm256_testz_si256(error, error)) {
+            // Ошибка в этом блоке или в последовательности, начатой не раньше
+            // трёх байт до него; точное место ищется скалярно с первого
+            // начала символа в этой области
+            size_t from = pos - start >= 3 ? pos - 3 : start;
+            while (from < pos && (static_cast<unsigned char>(data[from]) & 0xC0) == 0x80) {
+                from++;
+            }
+            return validateUtf8Scalar(data, from, end);
+        }
+        previous = input;
+        pos += 32;
+    }
+    return end;
+}
+
+#endif // SCANNER_X86
+
+inline Scanner selectScanner() {
+#ifdef SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {skipWhitespaceAvx2, findLineEndAvx2, findCommentEndAvx2, findQuoteOrEscapeAvx2,
+                validateUtf8Avx2};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return {skipWhitespaceSse2, findLineEndSse2, findCommentEndSse2, findQuoteOrEscapeSse2,
+                validateUtf8Sse2};
+    }
+#endif
+    return {skipWhitespaceScalar, findLineEndScalar, findCommentEndScalar, findQuoteOrEscapeScalar,
+            validateUtf8Scalar};
+}
+
+} // namespace scanner_detail
+
+// Сканер, подходящий для текущего процессора
+inline const Scanner& scanner() {
+    static const Scanner instance = scanner_detail::selectScanner();
+    return instance;
+}
+
+#endif // SCANNER_HPP
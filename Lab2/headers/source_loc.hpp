@@ -0,0 +1,127 @@
+#ifndef SOURCE_LOC_HPP
+#define SOURCE_LOC_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Позиция в исходном файле - смещение в байтах от его начала.
+// Строка и столбец вычисляются по LineTable только для диагностики.
+using SourceLoc = uint32_t;
+constexpr SourceLoc NO_LOC = UINT32_MAX;
+
+struct LineColumn {
+    int line;   // с 1
+    int column; // с 1
+};
+
+// Таблица начал строк файла. Первая строка начинается с 0 и в таблице не
+// хранится, поэтому таблицы соседних частей файла просто склеиваются.
+// Строки считаются так же, как в лексере. Таблица, построенная
+// synthesize(), хранит рядом с началом строки её номер и пропускает
+// строки без токенов.
+class LineTable {
+public:
+    // Начало следующей строки; смещения добавляются по возрастанию
+    void addLine(SourceLoc start) {
+        starts.push_back(start);
+    }
+
+    void append(const LineTable& other) {
+        starts.insert(starts.end(), other.starts.begin(), other.starts.end());
+    }
+
+    void clear() {
+        starts.clear();
+        numbers.clear();
+        synthetic = 0;
+    }
+
+    // Начала строк со второй, например для записи таблицы в файл
+    const std::vector<SourceLoc>& lineStarts() const {
+        return starts;
+    }
+
+    // Номер последней строки
+    size_t lineCount() const {
+        return numbers.empty() ? starts.size() + 1 : numbers.back();
+    }
+
+    LineColumn resolve(SourceLoc loc) const {
+        if (loc == NO_LOC) {
+            return {0, 0};
+        }
+        size_t index = std::upper_bound(starts.begin(), starts.end(), loc) - starts.begin();
+        SourceLoc lineStart = index == 0 ? 0 : starts[index - 1];
+        int line = index == 0 ? 1 : numbers.empty() ? static_cast<int>(index) + 1 : static_cast<int>(numbers[index - 1]);
+        return {line, static_cast<int>(loc - lineStart) + 1};
+    }
+
+    // "строка:столбец" для сообщений об ошибках
+    std::string format(SourceLoc loc) const {
+        LineColumn position = resolve(loc);
+        return std::to_string(position.line) + ":" + std::to_string(position.column);
+    }
+
+    // Позиция для токена из файла токенов, где исходника нет. Строки
+    // раскладываются подряд так, чтобы resolve() вернул записанные строку и
+    // столбец; без столбца (0) токены строки идут через один пробел.
+    // Каждый токен добавляет в таблицу не больше одной строки, как бы
+    // далеко ни прыгал номер; позиция, не помещающаяся в SourceLoc
+    // (см. canSynthesize), даёт NO_LOC.
+    SourceLoc synthesize(int line, int column, size_t length) {
+        if (!canSynthesize(line, column, length)) {
+            return NO_LOC;
+        }
+        if (line > 1 && static_cast<size_t>(line) > lineCount()) {
+            synthetic++;
+            starts.push_back(synthetic);
+            numbers.push_back(static_cast<uint32_t>(line));
+        }
+        SourceLoc lineStart = startOf(line);
+        SourceLoc loc = column > 0 ? lineStart + static_cast<SourceLoc>(column - 1)
+                                   : std::max(synthetic, lineStart);
+        synthetic = std::max(synthetic, static_cast<SourceLoc>(loc + length + 1));
+        return loc;
+    }
+
+    // Позиция токена вместе с его длиной помещается в SourceLoc
+    bool canSynthesize(int line, int column, size_t length) const {
+        if (column < 0 || length >= NO_LOC) {
+            return false;
+        }
+        uint64_t lineStart = line > 1 && static_cast<size_t>(line) > lineCount() ? uint64_t(synthetic) + 1
+                                                                                  : startOf(line);
+        uint64_t loc = column > 0 ? lineStart + column - 1 : std::max<uint64_t>(synthetic, lineStart);
+        return loc + length + 1 < NO_LOC;
+    }
+
+    // Таблица текущего транслируемого файла
+    static LineTable& global() {
+        static LineTable instance;
+        return instance;
+    }
+
+private:
+    // Начало уже заведённой строки. Строку без токенов (номер меньше
+    // последнего) synthesize() не заводит: её позиции идут в конец
+    SourceLoc startOf(int line) const {
+        if (line <= 1) {
+            return 0;
+        }
+        if (numbers.empty()) {
+            return static_cast<size_t>(line) - 2 < starts.size() ? starts[line - 2] : synthetic;
+        }
+        auto found = std::lower_bound(numbers.begin(), numbers.end(), static_cast<uint32_t>(line));
+        return found != numbers.end() && *found == static_cast<uint32_t>(line) ? starts[found - numbers.begin()]
+                                                                               : synthetic;
+    }
+
+    std::vector<SourceLoc> starts;
+    std::vector<uint32_t> numbers; // номера строк starts; пусто - строки идут подряд
+    SourceLoc synthetic = 0; // конец занятой части при synthesize()
+};
+
+#endif // SOURCE_LOC_HPP
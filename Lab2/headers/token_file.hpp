@@ -0,0 +1,248 @@
+#ifndef TOKEN_FILE_HPP
+#define TOKEN_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Двоичный файл токенов, который лексер передаёт парсеру.
+//
+//   TokenFileHeader
+//   TokenRecord[tokenCount]             - записи фиксированной длины
+//   uint32_t offsets[stringCount + 1]   - таблица строк: смещения лексем
+//   char bytes[]                          и их байты подряд
+//
+// Лексема записи - номер в таблице строк (0 - пустая строка). Числа
+// записываются в порядке байтов машины (little-endian для x86).
+constexpr char TOKEN_FILE_MAGIC[4] = {'M', 'T', 'O', 'K'};
+constexpr uint32_t TOKEN_FILE_VERSION = 1;
+
+struct TokenFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t tokenCount;
+    uint32_t stringCount;   // включая пустую строку с номером 0
+    uint64_t tokensOffset;
+    uint64_t stringsOffset;
+    uint64_t fileSize;
+};
+
+struct TokenRecord {
+    uint8_t type;      // TokenType
+    uint8_t kind;      // TokenKind
+    uint16_t reserved;
+    uint32_t lexeme;   // номер в таблице строк
+    uint32_t line;
+    uint32_t column;
+};
+
+static_assert(sizeof(TokenFileHeader) == 40, "заголовок файла токенов должен быть 40 байт");
+static_assert(sizeof(TokenRecord) == 16, "запись токена должна быть 16 байт");
+
+// Потоковая запись: записи идут сразу в файл, таблица строк и
+// заголовок дописываются в finish(), когда известно число лексем
+class TokenFileWriter {
+public:
+    ~TokenFileWriter() {
+        removeSpool();
+    }
+
+    bool open(const std::string& path) {
+        out.open(path, std::ios::binary | std::ios::trunc);
+        TokenFileHeader header{};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        tokenCount = 0;
+        return static_cast<bool>(out);
+    }
+
+    // Запись без общего пула строк, для потокового лексера: каждая лексема
+    // получает в таблице строк свой номер, а её байты и смещение копятся
+    // во временных файлах рядом с выходным. Память не зависит от числа
+    // токенов; файл завершается finishSpooled()
+    bool openSpooled(const std::string& path) {
+        spoolPath = path;
+        spoolBytes.open(path + ".bytes", std::ios::binary | std::ios::trunc);
+        spoolOffsets.open(path + ".offsets", std::ios::binary | std::ios::trunc);
+        spoolTotal = 0;
+        return open(path) && spoolBytes && spoolOffsets;
+    }
+
+    void write(uint8_t type, uint8_t kind, uint32_t lexeme, uint32_t line, uint32_t column) {
+        TokenRecord record{type, kind, 0, lexeme, line, column};
+        out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        tokenCount++;
+    }
+
+    // Возвращает номер, под которым лексема записана в таблицу строк
+    uint32_t writeSpooled(uint8_t type, uint8_t kind, std::string_view lexeme, uint32_t line, uint32_t column) {
+        uint32_t id = tokenCount + 1;
+        write(type, kind, id, line, column);
+        spoolBytes.write(lexeme.data(), lexeme.size());
+        spoolTotal += static_cast<uint32_t>(lexeme.size());
+        spoolOffsets.write(reinterpret_cast<const char*>(&spoolTotal), sizeof(spoolTotal));
+        return id;
+    }
+
+    // strings[id] - текст лексемы с номером id, strings[0] пустая
+    template <typename StringAt>
+    bool finish(uint32_t stringCount, StringAt&& strings) {
+        TokenFileHeader header{};
+        std::memcpy(header.magic, TOKEN_FILE_MAGIC, sizeof(header.magic));
+        header.version = TOKEN_FILE_VERSION;
+        header.tokenCount = tokenCount;
+        header.stringCount = stringCount;
+        header.tokensOffset = sizeof(TokenFileHeader);
+        header.stringsOffset = header.tokensOffset + uint64_t(tokenCount) * sizeof(TokenRecord);
+
+        std::vector<uint32_t> offsets(stringCount + 1);
+        uint32_t total = 0;
+        for (uint32_t id = 0; id < stringCount; id++) {
+            offsets[id] = total;
+            total += static_cast<uint32_t>(std::string_view(strings(id)).size());
+        }
+        offsets[stringCount] = total;
+        out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+        for (uint32_t id = 0; id < stringCount; id++) {
+            std::string_view text = strings(id);
+            out.write(text.data(), text.size());
+        }
+        header.fileSize = header.stringsOffset + offsets.size() * sizeof(uint32_t) + total;
+
+        return finishHeader(header);
+    }
+
+    // Таблица строк из временных файлов: пустая строка 0 и по лексеме на
+    // каждую запись, в порядке записей
+    bool finishSpooled() {
+        spoolBytes.close();
+        spoolOffsets.close();
+        TokenFileHeader header{};
+        std::memcpy(header.magic, TOKEN_FILE_MAGIC, sizeof(header.magic));
+        header.version = TOKEN_FILE_VERSION;
+        header.tokenCount = tokenCount;
+        header.stringCount = tokenCount + 1;
+        header.tokensOffset = sizeof(TokenFileHeader);
+        header.stringsOffset = header.tokensOffset + uint64_t(tokenCount) * sizeof(TokenRecord);
+
+        uint32_t first[2] = {0, 0}; // начало пустой строки и первой лексемы
+        out.write(reinterpret_cast<const char*>(first), sizeof(first));
+        bool copied = !spoolBytes.fail() && !spoolOffsets.fail() &&
+                      appendFile(spoolPath + ".offsets") && appendFile(spoolPath + ".bytes");
+        removeSpool();
+        header.fileSize = header.stringsOffset + (uint64_t(tokenCount) + 2) * sizeof(uint32_t) + spoolTotal;
+        return finishHeader(header) && copied;
+    }
+
+private:
+    static constexpr size_t COPY_BLOCK = 1 << 20;
+
+    bool finishHeader(const TokenFileHeader& header) {
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        return !out.fail();
+    }
+
+    // Дописывает временный файл в выходной блоками по COPY_BLOCK байт
+    bool appendFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> block(COPY_BLOCK);
+        while (in) {
+            in.read(block.data(), static_cast<std::streamsize>(block.size()));
+            out.write(block.data(), in.gcount());
+        }
+        return in.eof() && static_cast<bool>(out);
+    }
+
+    void removeSpool() {
+        if (!spoolPath.empty()) {
+            spoolBytes.close();
+            spoolOffsets.close();
+            std::remove((spoolPath + ".bytes").c_str());
+            std::remove((spoolPath + ".offsets").c_str());
+            spoolPath.clear();
+        }
+    }
+
+    std::ofstream out;
+    uint32_t tokenCount = 0;
+    std::string spoolPath;      // пусто, если временных файлов нет
+    std::ofstream spoolBytes;   // байты лексем подряд
+    std::ofstream spoolOffsets; // смещение конца каждой лексемы
+    uint32_t spoolTotal = 0;
+};
+
+// Представление файла токенов поверх отображённой памяти: ничего не
+// копирует и не разбирает, только проверяет заголовок и границы
+class TokenFileView {
+public:
+    static bool isTokenFile(std::string_view data) {
+        return data.size() >= sizeof(TokenFileHeader) &&
+               std::memcmp(data.data(), TOKEN_FILE_MAGIC, sizeof(TOKEN_FILE_MAGIC)) == 0;
+    }
+
+    // Возвращает false, если файл повреждён или другой версии
+    bool open(std::string_view data) {
+        if (!isTokenFile(data)) {
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (header.version != TOKEN_FILE_VERSION || header.fileSize != data.size() ||
+            header.tokensOffset != sizeof(TokenFileHeader) ||
+            header.tokensOffset + uint64_t(header.tokenCount) * sizeof(TokenRecord) != header.stringsOffset ||
+            header.stringsOffset + (uint64_t(header.stringCount) + 1) * sizeof(uint32_t) > data.size()) {
+            return false;
+        }
+        records = reinterpret_cast<const TokenRecord*>(data.data() + header.tokensOffset);
+        offsets = reinterpret_cast<const uint32_t*>(data.data() + header.stringsOffset);
+        bytes = reinterpret_cast<const char*>(offsets + header.stringCount + 1);
+        size_t bytesSize = data.size() - (bytes - data.data());
+        if (offsets[header.stringCount] != bytesSize) {
+            return false;
+        }
+        for (uint32_t i = 0; i < header.stringCount; i++) {
+            if (offsets[i] > offsets[i + 1]) {
+                return false;
+            }
+        }
+        // Позиции: строки не убывают, а сумма столбцов и длин лексем с
+        // запасом помещается в 32-битное смещение, в которое парсер
+        // раскладывает позиции (каждая запись заводит не больше одной строки)
+        uint32_t previousLine = 0;
+        uint64_t extent = 0;
+        for (uint32_t i = 0; i < header.tokenCount; i++) {
+            const TokenRecord& record = records[i];
+            if (record.lexeme >= header.stringCount || record.line < previousLine ||
+                record.line > INT32_MAX || record.column > INT32_MAX) {
+                return false;
+            }
+            previousLine = record.line;
+            extent += uint64_t(record.column) + (offsets[record.lexeme + 1] - offsets[record.lexeme]) + 2;
+            if (extent >= UINT32_MAX) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t tokenCount() const { return header.tokenCount; }
+    uint32_t stringCount() const { return header.stringCount; }
+    const TokenRecord& record(uint32_t index) const { return records[index]; }
+
+    std::string_view string(uint32_t id) const {
+        return std::string_view(bytes + offsets[id], offsets[id + 1] - offsets[id]);
+    }
+
+private:
+    TokenFileHeader header{};
+    const TokenRecord* records = nullptr;
+    const uint32_t* offsets = nullptr;
+    const char* bytes = nullptr;
+};
+
+#endif // TOKEN_FILE_HPP
@@ -0,0 +1,144 @@
+#ifndef TOKEN_SOURCE_HPP
+#define TOKEN_SOURCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "lexer.hpp"
+
+// Источник токенов для парсера. Токены запрашиваются у produce() по мере
+// надобности и хранятся в небольшом кольцевом буфере: в нём есть текущий
+// токен, до MAX_LOOKAHEAD следующих и несколько уже прочитанных для
+// previous() и unconsume(). После конца входа выдаётся токен EOF с
+// пустой лексемой и позицией последнего токена.
+class TokenSource {
+public:
+    static constexpr size_t MAX_LOOKAHEAD = 8;
+
+    virtual ~TokenSource() = default;
+
+    // Токен на ahead позиций впереди текущего
+    const Token& peek(size_t ahead = 0) {
+        if (ahead >= MAX_LOOKAHEAD) {
+            throw std::out_of_range("Token lookahead is too far");
+        }
+        fill(head + ahead);
+        return ring[(head + ahead) & RING_MASK];
+    }
+
+    const Token& previous() const {
+        return ring[(head - 1) & RING_MASK];
+    }
+
+    // Ссылка остаётся верной, пока не прочитано ещё
+    // RING_SIZE - MAX_LOOKAHEAD токенов
+    const Token& consume() {
+        const Token& token = peek();
+        head++;
+        return token;
+    }
+
+    // Возврат на один токен назад
+    void unconsume() {
+        if (head == 0 || head + RING_SIZE <= filled) {
+            throw std::out_of_range("Token history is exhausted");
+        }
+        head--;
+    }
+
+    bool atEnd() {
+        fill(head);
+        return head >= endIndex;
+    }
+
+    // Номер текущего токена от начала входа
+    size_t position() const {
+        return head;
+    }
+
+protected:
+    // Следующий токен входа; false - токены закончились
+    virtual bool produce(Token& token) = 0;
+
+private:
+    static constexpr size_t RING_SIZE = 32;
+    static constexpr size_t RING_MASK = RING_SIZE - 1;
+
+    // Дочитывает буфер до абсолютного номера index включительно
+    void fill(size_t index) {
+        while (filled <= index) {
+            Token& slot = ring[filled & RING_MASK];
+            if (filled >= endIndex || !produce(slot)) {
+                if (endIndex > filled) {
+                    endIndex = filled;
+                }
+                slot = Token{UNKNOWN, std::string_view(), lastLoc, NO_SYMBOL, TK_NONE};
+            } else {
+                lastLoc = slot.loc;
+            }
+            filled++;
+        }
+    }
+
+    Token ring[RING_SIZE] = {};
+    size_t head = 0;             // абсолютный номер текущего токена
+    size_t filled = 0;           // сколько токенов уже запрошено
+    size_t endIndex = SIZE_MAX;  // номер токена EOF
+    SourceLoc lastLoc = 0;       // позиция для токена EOF
+};
+
+// Токены, которые разбирает лексер по запросу парсера
+class LexerTokenSource : public TokenSource {
+public:
+    explicit LexerTokenSource(Lexer& lexer) : lexer(lexer) {}
+
+protected:
+    bool produce(Token& token) override {
+        return lexer.nextToken(token);
+    }
+
+private:
+    Lexer& lexer;
+};
+
+// Токены из готового вектора (например, прочитанные из файла токенов)
+class VectorTokenSource : public TokenSource {
+public:
+    explicit VectorTokenSource(std::vector<Token> tokens) : tokens(std::move(tokens)) {}
+
+protected:
+    bool produce(Token& token) override {
+        if (index >= tokens.size()) {
+            return false;
+        }
+        token = tokens[index++];
+        return true;
+    }
+
+private:
+    std::vector<Token> tokens;
+    size_t index = 0;
+};
+
+// Токены из отрезка чужого массива; массив должен пережить источник
+class SpanTokenSource : public TokenSource {
+public:
+    SpanTokenSource(const Token* begin, const Token* end) : next(begin), end(end) {}
+
+protected:
+    bool produce(Token& token) override {
+        if (next == end) {
+            return false;
+        }
+        token = *next++;
+        return true;
+    }
+
+private:
+    const Token* next;
+    const Token* end;
+};
+
+#endif // TOKEN_SOURCE_HPP
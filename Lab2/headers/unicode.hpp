@@ -0,0 +1,202 @@
+#ifndef UNICODE_HPP
+#define UNICODE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Разбор UTF-8 и классы символов Unicode для идентификаторов Java.
+// Лексер обращается сюда только для байтов >= 0x80: ASCII разбирается
+// по его собственным таблицам.
+
+// Длина корректной последовательности UTF-8 в позиции pos и её код
+// в codePoint; 0 - последовательность неполная, избыточная (overlong),
+// суррогат или код больше U+10FFFF
+inline size_t decodeUtf8(const char* data, size_t pos, size_t end, char32_t& codePoint) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data) + pos;
+    size_t available = end - pos;
+    unsigned char lead = bytes[0];
+    if (lead < 0x80) {
+        codePoint = lead;
+        return 1;
+    }
+    size_t length;
+    char32_t value;
+    char32_t minimum;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        value = lead & 0x1F;
+        minimum = 0x80;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        value = lead & 0x0F;
+        minimum = 0x800;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        value = lead & 0x07;
+        minimum = 0x10000;
+    } else {
+        return 0;
+    }
+    if (available < length) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if ((bytes[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        value = (value << 6) | (bytes[i] & 0x3F);
+    }
+    if (value < minimum || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) {
+        return 0;
+    }
+    codePoint = value;
+    return length;
+}
+
+// Длина символа в позиции pos: корректная последовательность целиком,
+// иначе один байт
+inline size_t utf8CharLength(const char* data, size_t pos, size_t end) {
+    char32_t codePoint;
+    size_t length = decodeUtf8(data, pos, end, codePoint);
+    return length ? length : 1;
+}
+
+namespace unicode_detail {
+
+// Символ может начинать идентификатор (буквы, буквенные цифры, знаки
+// валют, соединители) или только продолжать его (комбинируемые знаки,
+// цифры других письменностей, невидимые символы форматирования)
+enum IdentifierFlags : unsigned char {
+    ID_START = 1,
+    ID_PART = 2
+};
+
+struct UnicodeRange {
+    char32_t first;
+    char32_t last;
+    unsigned char flags;
+};
+
+constexpr unsigned char S = ID_START | ID_PART;
+constexpr unsigned char P = ID_PART;
+
+// Диапазоны по возрастанию, без пересечений. Покрывают письменности,
+// которые встречаются в исходниках (латиница, греческий, кириллица,
+// армянский, иврит, арабский, индийские, грузинский, CJK, хангыль и др.);
+// это приближение Character.isJavaIdentifierStart/Part, а не полная база
+constexpr UnicodeRange identifierRanges[] = {
+    {0x00A2, 0x00A5, S}, {0x00AA, 0x00AA, S}, {0x00AD, 0x00AD, P}, {0x00B5, 0x00B5, S},
+    {0x00BA, 0x00BA, S}, {0x00C0, 0x00D6, S}, {0x00D8, 0x00F6, S}, {0x00F8, 0x02C1, S},
+    {0x02C6, 0x02D1, S}, {0x02E0, 0x02E4, S}, {0x02EC, 0x02EC, S}, {0x02EE, 0x02EE, S},
+    {0x0300, 0x036F, P}, {0x0370, 0x0374, S}, {0x0376, 0x0377, S}, {0x037A, 0x037D, S},
+    {0x037F, 0x037F, S}, {0x0386, 0x0386, S}, {0x0388, 0x038A, S}, {0x038C, 0x038C, S},
+    {0x038E, 0x03A1, S}, {0x03A3, 0x03F5, S}, {0x03F7, 0x0481, S}, {0x0483, 0x0487, P},
+    {0x048A, 0x052F, S}, {0x0531, 0x0556, S}, {0x0559, 0x0559, S}, {0x0560, 0x0588, S},
+    {0x058F, 0x058F, S}, {0x0591, 0x05BD, P}, {0x05BF, 0x05BF, P}, {0x05C1, 0x05C2, P},
+    {0x05C4, 0x05C5, P}, {0x05C7, 0x05C7, P}, {0x05D0, 0x05EA, S}, {0x05EF, 0x05F2, S},
+    {0x060B, 0x060B, S}, {0x0610, 0x061A, P}, {0x0620, 0x064A, S}, {0x064B, 0x0669, P},
+    {0x066E, 0x066F, S}, {0x0670, 0x0670, P}, {0x0671, 0x06D3, S}, {0x06D5, 0x06D5, S},
+    {0x06D6, 0x06DC, P}, {0x06DF, 0x06E4, P}, {0x06E5, 0x06E6, S}, {0x06E7, 0x06E8, P},
+    {0x06EA, 0x06ED, P}, {0x06EE, 0x06EF, S}, {0x06F0, 0x06F9, P}, {0x06FA, 0x06FC, S},
+    {0x06FF, 0x06FF, S}, {0x0710, 0x0710, S}, {0x0712, 0x072F, S}, {0x074D, 0x07A5, S},
+    {0x07B1, 0x07B1, S}, {0x07CA, 0x07EA, S}, {0x07F4, 0x07F5, S}, {0x07FA, 0x07FA, S},
+    {0x07FE, 0x07FF, S},
+    {0x0900, 0x0903, P}, {0x0904, 0x0939, S}, {0x093A, 0x093C, P}, {0x093D, 0x093D, S},
+    {0x093E, 0x094F, P}, {0x0950, 0x0950, S}, {0x0951, 0x0957, P}, {0x0958, 0x0961, S},
+    {0x0962, 0x0963, P}, {0x0966, 0x096F, P}, {0x0971, 0x097F, S},
+    {0x0E01, 0x0E30, S}, {0x0E31, 0x0E31, P}, {0x0E32, 0x0E33, S}, {0x0E34, 0x0E3A, P},
+    {0x0E3F, 0x0E3F, S}, {0x0E40, 0x0E46, S}, {0x0E47, 0x0E4E, P}, {0x0E50, 0x0E59, P},
+    {0x10A0, 0x10C5, S}, {0x10D0, 0x10FA, S}, {0x10FC, 0x10FF, S}, {0x1100, 0x11FF, S},
+    {0x1AB0, 0x1AFF, P}, {0x1DC0, 0x1DFF, P}, {0x1E00, 0x1F15, S}, {0x1F18, 0x1F1D, S},
+    {0x1F20, 0x1F45, S}, {0x1F48, 0x1F4D, S}, {0x1F50, 0x1F57, S}, {0x1F59, 0x1F59, S},
+    {0x1F5B, 0x1F5B, S}, {0x1F5D, 0x1F5D, S}, {0x1F5F, 0x1F7D, S}, {0x1F80, 0x1FB4, S},
+    {0x1FB6, 0x1FBC, S}, {0x1FBE, 0x1FBE, S}, {0x1FC2, 0x1FC4, S}, {0x1FC6, 0x1FCC, S},
+    {0x1FD0, 0x1FD3, S}, {0x1FD6, 0x1FDB, S}, {0x1FE0, 0x1FEC, S}, {0x1FF2, 0x1FF4, S},
+    {0x1FF6, 0x1FFC, S},
+    {0x200B, 0x200F, P}, {0x202A, 0x202E, P}, {0x203F, 0x2040, S}, {0x2054, 0x2054, S},
+    {0x2060, 0x2064, P}, {0x2071, 0x2071, S}, {0x207F, 0x207F, S}, {0x2090, 0x209C, S},
+    {0x20A0, 0x20C0, S}, {0x20D0, 0x20FF, P}, {0x2102, 0x2102, S}, {0x2107, 0x2107, S},
+    {0x210A, 0x2113, S}, {0x2115, 0x2115, S}, {0x2119, 0x211D, S}, {0x2124, 0x2124, S},
+    {0x2126, 0x2126, S}, {0x2128, 0x2128, S}, {0x212A, 0x212D, S}, {0x212F, 0x2139, S},
+    {0x213C, 0x213F, S}, {0x2145, 0x2149, S}, {0x214E, 0x214E, S}, {0x2160, 0x2188, S},
+    {0x2C00, 0x2CE4, S}, {0x2D00, 0x2D25, S}, {0x2DE0, 0x2DFF, P},
+    {0x3005, 0x3007, S}, {0x3021, 0x3029, S}, {0x302A, 0x302F, P}, {0x3031, 0x3035, S},
+    {0x3038, 0x303C, S}, {0x3041, 0x3096, S}, {0x3099, 0x309A, P}, {0x309D, 0x309F, S},
+    {0x30A1, 0x30FA, S}, {0x30FC, 0x30FF, S}, {0x3105, 0x312F, S}, {0x3131, 0x318E, S},
+    {0x31A0, 0x31BF, S}, {0x31F0, 0x31FF, S}, {0x3400, 0x4DBF, S}, {0x4E00, 0xA48C, S},
+    {0xA640, 0xA66E, S}, {0xA66F, 0xA66F, P}, {0xA674, 0xA67D, P}, {0xA67F, 0xA69D, S},
+    {0xA69E, 0xA69F, P}, {0xA722, 0xA788, S}, {0xA78B, 0xA7CA, S}, {0xAC00, 0xD7A3, S},
+    {0xF900, 0xFA6D, S}, {0xFB00, 0xFB06, S}, {0xFB13, 0xFB17, S}, {0xFB1D, 0xFB1D, S},
+    {0xFB1E, 0xFB1E, P}, {0xFB1F, 0xFB28, S}, {0xFB2A, 0xFBB1, S}, {0xFBD3, 0xFD3D, S},
+    {0xFD50, 0xFDC7, S}, {0xFDF0, 0xFDFC, S}, {0xFE00, 0xFE0F, P}, {0xFE20, 0xFE2F, P},
+    {0xFE33, 0xFE34, S}, {0xFE4D, 0xFE4F, S}, {0xFE69, 0xFE69, S}, {0xFE70, 0xFEFC, S},
+    {0xFEFF, 0xFEFF, P}, {0xFF04, 0xFF04, S}, {0xFF10, 0xFF19, P}, {0xFF21, 0xFF3A, S},
+    {0xFF3F, 0xFF3F, S}, {0xFF41, 0xFF5A, S}, {0xFF66, 0xFFBE, S}, {0xFFE0, 0xFFE1, S},
+    {0xFFE5, 0xFFE6, S},
+    {0x1D400, 0x1D6A5, S}, {0x20000, 0x2A6DF, S}, {0x2A700, 0x2EBE0, S}, {0x30000, 0x3134A, S}
+};
+
+constexpr size_t IDENTIFIER_RANGE_COUNT = sizeof(identifierRanges) / sizeof(identifierRanges[0]);
+
+// Символы до U+0800 (двухбайтовые: кириллица, греческий, иврит, арабский
+// и др.) классифицируются прямой таблицей, остальные - двоичным поиском
+constexpr char32_t DIRECT_TABLE_SIZE = 0x800;
+
+struct DirectTable {
+    unsigned char flags[DIRECT_TABLE_SIZE];
+};
+
+constexpr DirectTable buildDirectTable() {
+    DirectTable table{};
+    for (const UnicodeRange& range : identifierRanges) {
+        for (char32_t c = range.first; c <= range.last && c < DIRECT_TABLE_SIZE; c++) {
+            table.flags[c] = range.flags;
+        }
+    }
+    return table;
+}
+
+constexpr bool rangesAreOrdered() {
+    for (size_t i = 0; i < IDENTIFIER_RANGE_COUNT; i++) {
+        if (identifierRanges[i].first > identifierRanges[i].last || identifierRanges[i].first < 0x80 ||
+            (i > 0 && identifierRanges[i - 1].last >= identifierRanges[i].first)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(rangesAreOrdered(), "диапазоны identifierRanges должны идти по возрастанию");
+
+constexpr DirectTable directTable = buildDirectTable();
+
+inline unsigned char identifierFlags(char32_t c) {
+    if (c < DIRECT_TABLE_SIZE) {
+        return directTable.flags[c];
+    }
+    size_t low = 0;
+    size_t high = IDENTIFIER_RANGE_COUNT;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (identifierRanges[middle].last < c) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < IDENTIFIER_RANGE_COUNT && identifierRanges[low].first <= c ? identifierRanges[low].flags : 0;
+}
+
+} // namespace unicode_detail
+
+// Символ вне ASCII, с которого может начинаться идентификатор Java
+inline bool isUnicodeIdentifierStart(char32_t c) {
+    return (unicode_detail::identifierFlags(c) & unicode_detail::ID_START) != 0;
+}
+
+// Символ вне ASCII, который может продолжать идентификатор Java
+inline bool isUnicodeIdentifierPart(char32_t c) {
+    return (unicode_detail::identifierFlags(c) & unicode_detail::ID_PART) != 0;
+}
+
+#endif // UNICODE_HPP
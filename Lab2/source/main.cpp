@@ -1,262 +1,114 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <thread>
 #include <vector>
-#include <unordered_set>
-#include <unordered_map>
-#include <cctype>
-#include <sstream>
+#include "lexer.hpp"
+#include "mapped_file.hpp"
+#include "token_file.hpp"
 
-// Типы токенов
-enum TokenType {
-    KEYWORD,
-    IDENTIFIER,
-    NUMBER,
-    FLOAT_NUMBER,
-    STRING_LITERAL,
-    CHAR_LITERAL,
-    OPERATOR,
-    UNKNOWN,
-    ERROR
-};
-
-// Структура токена
-struct Token {
-    TokenType type;
-    std::string value;
-    int line;
-    int id;
-
-    std::string typeToString() const {
-        switch (type) {
-            case KEYWORD: return "KEYWORD";
-            case IDENTIFIER: return "IDENTIFIER";
-            case NUMBER: return "NUMBER";
-            case FLOAT_NUMBER: return "FLOAT_NUMBER";
-            case STRING_LITERAL: return "STRING_LITERAL";
-            case CHAR_LITERAL: return "CHAR_LITERAL";
-            case OPERATOR: return "OPERATOR";
-            case ERROR: return "ERROR";
-            default: return "UNKNOWN";
-        }
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <source_file> [--stream | --parallel] [--dump-text]\n";
+        return 1;
     }
-};
-
-// Список ключевых слов Java
-const std::unordered_set<std::string> javaKeywords = {
-    "abstract", "assert", "boolean", "break", "byte", "case", "catch", "char", "class", "const",
-    "continue", "default", "do", "double", "double[]", "else", "enum", "extends", "final", "finally", "float",
-    "float[]", "for", "goto", "if", "implements", "import", "instanceof", "int", "int[]", "interface", "long", 
-    "long[]", "native", "new", "null", "package", "private", "protected", "public", "return", "short", "short[]", 
-    "static", "strictfp", "super", "switch", "synchronized", "this", "throw", "throws", "transient", "try",
-    "void", "volatile", "while", "true", "false", "String", "String[]", "ArrayList", "HashMap", "HashSet"
-};
-
-// Список операторов Java
-const std::unordered_set<std::string> javaOperators = {
-    "+", "-", "*", "/", "%", "++", "--", "==", "!=", ">", "<", ">=", "<=", "&&", "||", "!", "=",
-    "+=", "-=", "*=", "/=", "%=", "&", "|", "^", "~", "<<", ">>", ">>>", "?", ":", "::", ".", ",",
-    ";", "(", ")", "{", "}", "[", "]"
-};
-
-// Класс лексического анализатора
-class Lexer {
-public:
-    explicit Lexer(const std::string& sourceCode) 
-        : source(sourceCode), pos(0), line(1), nextTokenId(1) {}
-
-    // Основная функция для токенизации
-    std::vector<Token> tokenize() {
-        tokens.clear();
-        while (pos < source.length()) {
-            char currentChar = source[pos];
-
-            if (std::isspace(currentChar)) {
-                if (currentChar == '\n') {
-                    line++; // Увеличиваем номер строки
-                }
-                pos++; // Пропускаем пробелы
-            } else if (std::isalpha(currentChar) || currentChar == '_') {
-                tokens.push_back(consumeIdentifierOrKeyword());
-            } else if (std::isdigit(currentChar) || 
-                        (currentChar == '.' && pos + 1 < source.length() && std::isdigit(source[pos + 1]))) {
-                tokens.push_back(consumeNumber());
-            } else if (currentChar == '"') {
-                tokens.push_back(consumeStringLiteral());
-            } else if (currentChar == '\'') {
-                tokens.push_back(consumeCharLiteral());
-            } else if (currentChar == '/' && (pos + 1 < source.length() && (source[pos + 1] == '/' || source[pos + 1] == '*'))) {
-                consumeComment(); // Игнорируем комментарии
-            } else if (isOperator(std::string(1, currentChar))) {
-                tokens.push_back(consumeOperator());
-            } else {
-                tokens.push_back(createToken(ERROR, std::string(1, currentChar)));
-                pos++;
-            }
+    // --stream: чтение файла блоками; память ограничена блоком и самой
+    //           длинной лексемой, таблица строк файла токенов пишется
+    //           через временные файлы без общего пула строк
+    // --parallel: разбор долями файла на всех ядрах
+    // --dump-text: дополнительно записать токены текстом для отладки
+    bool streaming = false;
+    bool parallel = false;
+    bool dumpText = false;
+    for (int i = 2; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--stream") streaming = true;
+        else if (option == "--parallel") parallel = true;
+        else if (option == "--dump-text") dumpText = true;
+        else {
+            std::cerr << "Unknown option " << option << "\n";
+            return 1;
         }
-        return tokens;
     }
 
-private:
-    std::string source;
-    size_t pos;
-    int line;
-    int nextTokenId;
-    std::vector<Token> tokens;
-    std::unordered_map<std::string, int> tokenIds; // Хранение ID токенов
-
-    bool isOperator(const std::string& op) {
-        return javaOperators.find(op) != javaOperators.end();
-    }
+    std::string token_file_name = "D:\\Study\\6_semestr\\MTran\\output.tok";
+    std::string output_file_name = "D:\\Study\\6_semestr\\MTran\\output.txt";
 
-    Token createToken(TokenType type, const std::string& value) {
-        if (tokenIds.find(value) == tokenIds.end()) {
-            tokenIds[value] = nextTokenId++;
-        }
-        return {type, value, line, tokenIds[value]};
+    TokenFileWriter tokenFile;
+    if (!(streaming ? tokenFile.openSpooled(token_file_name) : tokenFile.open(token_file_name))) {
+        std::cerr << "Error: Could not open output file\n";
+        return 1;
     }
-
-    Token consumeIdentifierOrKeyword() {
-        size_t start = pos;
-        while (pos < source.length() && (std::isalnum(source[pos]) || source[pos] == '_' || source[pos] == '[' || source[pos] == ']')) {
-            pos++;
+    std::ofstream textFile;
+    if (dumpText) {
+        textFile.open(output_file_name);
+        if (!textFile) {
+            std::cerr << "Error: Could not open output file\n";
+            return 1;
         }
-        std::string word = source.substr(start, pos - start);
-        return createToken(javaKeywords.find(word) != javaKeywords.end() ? KEYWORD : IDENTIFIER, word);
     }
-
-    Token consumeNumber() {
-        size_t start = pos;
-        bool isFloat = false;
-
-        if (pos > 0 && (source[pos - 1] == '-' || source[pos - 1] == '+') && 
-            (pos - 1 == 0 || std::isspace(source[pos - 2]) || source[pos - 2] == '=')) {
-            tokens.pop_back();
-            start = pos - 1;
+    const LineTable& lines = LineTable::global();
+    auto writeOut = [&](const Token& token) {
+        LineColumn position = lines.resolve(token.loc);
+        tokenFile.write(token.type, token.kind, token.id, position.line, position.column);
+        if (dumpText) {
+            writeToken(textFile, token, lines);
         }
-
-        while (pos < source.length() && (std::isdigit(source[pos]) || source[pos] == '.')) {
-            if (source[pos] == '.') {
-                if (isFloat) {
-                    return createToken(ERROR, source.substr(start, pos - start));
-                }
-                isFloat = true;
-            }
-            pos++;
+    };
+
+    // Файл отображается в память, токены ссылаются прямо на него
+    MappedFile inputFile;
+    if (streaming) {
+        std::ifstream input(argv[1], std::ios::binary);
+        if (!input) {
+            std::cerr << "Error: Could not open file " << argv[1] << "\n";
+            return 1;
         }
-
-        if (pos < source.length() && (source[pos] == 'e' || source[pos] == 'E')) {
-            isFloat = true;
-            pos++;
-            if (pos < source.length() && (source[pos] == '+' || source[pos] == '-')) {
-                pos++;
-            }
-            if (pos >= source.length() || !std::isdigit(source[pos])) {
-                return createToken(ERROR, source.substr(start, pos - start));
-            }
-            while (pos < source.length() && std::isdigit(source[pos])) {
-                pos++;
+        Lexer lexer;
+        bool complete = lexer.tokenizeStream(input, [&](const Token& token, const LineColumn& position) {
+            Token written = token;
+            written.id = tokenFile.writeSpooled(token.type, token.kind, token.lexeme, position.line, position.column);
+            if (dumpText) {
+                writeToken(textFile, written, position.line);
             }
+        });
+        if (!complete) {
+            std::cerr << "Error: File " << argv[1] << " is larger than 4 GiB\n";
+            return 1;
         }
-
-        if (pos < source.length() && (source[pos] == 'f' || source[pos] == 'F' || source[pos] == 'd' || source[pos] == 'D')) {
-            isFloat = true;
-            pos++;
+        if (!tokenFile.finishSpooled()) {
+            std::cerr << "Error: Could not write output file\n";
+            return 1;
         }
-
-        return createToken(isFloat ? FLOAT_NUMBER : NUMBER, source.substr(start, pos - start));
-    }
-
-    Token consumeStringLiteral() {
-        size_t start = pos;
-        pos++;
-        while (pos < source.length() && source[pos] != '"') {
-            if (source[pos] == '\\' && pos + 1 < source.length()) {
-                pos += 2;
-            } else {
-                pos++;
-            }
+    } else {
+        if (!inputFile.open(argv[1])) {
+            std::cerr << "Error: Could not open file " << argv[1] << "\n";
+            return 1;
         }
-        if (pos < source.length() && source[pos] == '"') {
-            pos++;
-            return createToken(STRING_LITERAL, source.substr(start, pos - start));
+        if (inputFile.view().size() >= NO_LOC) {
+            std::cerr << "Error: File " << argv[1] << " is larger than 4 GiB\n";
+            return 1;
         }
-        return createToken(ERROR, source.substr(start, pos - start));
-    }
-
-    Token consumeCharLiteral() {
-        size_t start = pos;
-        pos++;
-        if (pos < source.length() && source[pos] == '\\') {
-            pos += 2;
+        std::vector<Token> tokens;
+        if (parallel) {
+            tokens = tokenizeParallel(inputFile.view(), std::max(1u, std::thread::hardware_concurrency()));
         } else {
-            pos++;
+            Lexer lexer(inputFile.view());
+            tokens = lexer.tokenize();
         }
-        if (pos < source.length() && source[pos] == '\'') {
-            pos++;
-            return createToken(CHAR_LITERAL, source.substr(start, pos - start));
+        for (const Token& token : tokens) {
+            writeOut(token);
         }
-        return createToken(ERROR, source.substr(start, pos - start));
-    }
-
-    void consumeComment() {
-        if (source[pos + 1] == '/') {
-            pos += 2;
-            while (pos < source.length() && source[pos] != '\n') {
-                pos++;
-            }
-        } else if (source[pos + 1] == '*') {
-            pos += 2;
-            while (pos + 1 < source.length() && !(source[pos] == '*' && source[pos + 1] == '/')) {
-                pos++;
-            }
-            if (pos + 1 < source.length()) {
-                pos += 2;
-            }
-        }
-    }
-
-    Token consumeOperator() {
-        size_t start = pos;
-        while (pos < source.length() && isOperator(source.substr(start, pos - start + 1))) {
-            pos++;
+        Interner& symbols = Interner::global();
+        if (!tokenFile.finish(static_cast<uint32_t>(symbols.size() + 1), [&symbols](uint32_t id) {
+                return symbols.name(id);
+            })) {
+            std::cerr << "Error: Could not write output file\n";
+            return 1;
         }
-        return createToken(OPERATOR, source.substr(start, pos - start));
-    }
-};
-
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <source_file>\n";
-        return 1;
-    }
-
-    std::ifstream inputFile(argv[1]);
-    if (!inputFile) {
-        std::cerr << "Error: Could not open file " << argv[1] << "\n";
-        return 1;
-    }
-
-    std::string sourceCode((std::istreambuf_iterator<char>(inputFile)),
-                           std::istreambuf_iterator<char>());
-
-    Lexer lexer(sourceCode);
-    std::vector<Token> tokens = lexer.tokenize();
-
-    std::string output_file_name = "D:\\Study\\6_semestr\\MTran\\output.txt";
-    std::ofstream outputFile(output_file_name);
-    if (!outputFile) {
-        std::cerr << "Error: Could not open output file\n";
-        return 1;
-    }
-
-    for (const Token& token : tokens) {
-        outputFile << "Token: " << token.typeToString()
-                   << " Lexem: @" << token.value << "@"
-                   << " Line: " << token.line
-                   << " Id: " << token.id << "\n";
     }
 
-    std::cout << "Tokens written to output.txt\n";
+    std::cout << "Tokens written to output.tok" << (dumpText ? " and output.txt" : "") << "\n";
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "ast_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef NOGDI
+#define NOGDI // wingdi.h определяет макрос ERROR
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+uint64_t astCacheKey(std::string_view source, uint64_t maxDepth, bool lazy) {
+    uint64_t tail[3] = {TRANSLATOR_VERSION, maxDepth, lazy ? 1u : 0u};
+    return fnv1a64(std::string_view(reinterpret_cast<const char*>(tail), sizeof(tail)), fnv1a64(source));
+}
+
+std::string astCachePath(const std::string& sourcePath) {
+    size_t slash = sourcePath.find_last_of("/\\");
+    size_t dot = sourcePath.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return sourcePath + ".mtast";
+    }
+    return sourcePath.substr(0, dot) + ".mtast";
+}
+
+namespace {
+
+template <typename T>
+void appendArray(std::string& out, const T* items, size_t count) {
+    out.append(reinterpret_cast<const char*>(items), count * sizeof(T));
+}
+
+// Таблица имён файла: номера SymbolId заменяются на плотные номера с 1
+class NameTable {
+public:
+    uint32_t add(SymbolId id) {
+        if (id == NO_SYMBOL) {
+            return 0;
+        }
+        auto found = local.find(id);
+        if (found != local.end()) {
+            return found->second;
+        }
+        uint32_t index = static_cast<uint32_t>(ids.size() + 1);
+        local.emplace(id, index);
+        ids.push_back(id);
+        return index;
+    }
+
+    uint32_t count() const {
+        return static_cast<uint32_t>(ids.size() + 1);
+    }
+
+    void write(std::string& out) const {
+        Interner& symbols = Interner::global();
+        std::vector<uint32_t> offsets(count() + 1);
+        uint32_t total = 0;
+        for (uint32_t i = 1; i < count(); i++) {
+            offsets[i] = total;
+            total += static_cast<uint32_t>(symbols.name(ids[i - 1]).size());
+        }
+        offsets[count()] = total;
+        appendArray(out, offsets.data(), offsets.size());
+        for (SymbolId id : ids) {
+            out.append(symbols.name(id));
+        }
+    }
+
+private:
+    std::unordered_map<SymbolId, uint32_t> local;
+    std::vector<SymbolId> ids;
+};
+
+// Файл рядом с кэшем, свой у каждого процесса
+std::string temporaryPath(const std::string& path) {
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+    return path + ".tmp." + std::to_string(pid);
+}
+
+// Заменяет target файлом source одной операцией. Читатели, у которых
+// старый кэш уже отображён в память, продолжают видеть старый файл.
+// В Windows отображённый файл заменить нельзя - тогда кэш остаётся прежним.
+bool replaceFile(const std::string& source, const std::string& target) {
+#ifdef _WIN32
+    return MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(source.c_str(), target.c_str()) == 0;
+#endif
+}
+
+} // namespace
+
+// Файл пишется целиком под временным именем и затем переименовывается,
+// так что ни параллельный читатель, ни сбой посреди записи не оставят
+// на месте кэша обрезанный файл
+bool saveAstCache(const std::string& path, uint64_t key, const FlatAst& ast, const LineTable& lines) {
+    NameTable table;
+    std::vector<AstNodeRecord> records(ast.size());
+    for (NodeIndex i = 0; i < ast.size(); i++) {
+        const FlatAst::Payload& data = ast.payload[i];
+        AstNodeRecord& record = records[i];
+        record.kind = static_cast<uint8_t>(ast.kind[i]);
+        record.literalKind = static_cast<uint8_t>(data.literalKind);
+        record.op = static_cast<uint8_t>(data.op);
+        record.postfix = data.postfix ? 1 : 0;
+        record.loc = ast.loc[i];
+        record.firstChild = ast.firstChild[i];
+        record.childCount = ast.childCount[i];
+        record.subtreeEnd = ast.subtreeEnd[i];
+        record.name = table.add(data.name);
+        record.field = table.add(data.field);
+        record.typeName = table.add(data.typeName);
+        record.literalOffset = data.literalOffset;
+        record.literalLength = data.literalLength;
+    }
+
+    AstCacheHeader header{};
+    std::memcpy(header.magic, AST_CACHE_MAGIC, sizeof(header.magic));
+    header.version = AST_CACHE_VERSION;
+    header.key = key;
+    header.nodeCount = static_cast<uint32_t>(records.size());
+    header.childCount = static_cast<uint32_t>(ast.childList.size());
+    header.lineCount = static_cast<uint32_t>(lines.lineStarts().size());
+    header.symbolCount = table.count();
+    header.literalBytes = static_cast<uint32_t>(ast.strings.size());
+
+    std::string out;
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    appendArray(out, records.data(), records.size());
+    appendArray(out, ast.childList.data(), ast.childList.size());
+    appendArray(out, lines.lineStarts().data(), lines.lineStarts().size());
+    table.write(out);
+    out.append(ast.strings);
+    header.fileSize = out.size();
+    std::memcpy(&out[0], &header, sizeof(header));
+
+    std::string temporary = temporaryPath(path);
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(out.data(), out.size());
+    file.close();
+    if (file.fail() || !replaceFile(temporary, path)) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool loadAstCache(std::string_view data, uint64_t key, FlatAst& ast, LineTable& lines) {
+    AstCacheHeader header;
+    if (data.size() < sizeof(header) || std::memcmp(data.data(), AST_CACHE_MAGIC, sizeof(AST_CACHE_MAGIC)) != 0) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.version != AST_CACHE_VERSION || header.key != key || header.fileSize != data.size() ||
+        header.nodeCount == 0 || header.symbolCount == 0) {
+        return false;
+    }
+    uint64_t fixedSize = sizeof(header) + uint64_t(header.nodeCount) * sizeof(AstNodeRecord) +
+                         (uint64_t(header.childCount) + header.lineCount + header.symbolCount + 1) * sizeof(uint32_t);
+    if (fixedSize + header.literalBytes > data.size()) {
+        return false;
+    }
+    const AstNodeRecord* records = reinterpret_cast<const AstNodeRecord*>(data.data() + sizeof(header));
+    const uint32_t* childList = reinterpret_cast<const uint32_t*>(records + header.nodeCount);
+    const uint32_t* lineStarts = childList + header.childCount;
+    const uint32_t* offsets = lineStarts + header.lineCount;
+    const char* symbolBytes = data.data() + fixedSize;
+    if (fixedSize + offsets[header.symbolCount] + header.literalBytes != data.size()) {
+        return false;
+    }
+    for (uint32_t i = 0; i < header.symbolCount; i++) {
+        if (offsets[i] > offsets[i + 1]) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.childCount; i++) {
+        if (childList[i] >= header.nodeCount) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.nodeCount; i++) {
+        const AstNodeRecord& record = records[i];
+        if (record.kind > ASTNode::CONDITIONAL_EXPR || record.literalKind > ASTNode::BOOLEAN_LITERAL ||
+            record.op >= TOKEN_KIND_COUNT || record.name >= header.symbolCount ||
+            record.field >= header.symbolCount || record.typeName >= header.symbolCount ||
+            uint64_t(record.firstChild) + record.childCount > header.childCount ||
+            uint64_t(record.literalOffset) + record.literalLength > header.literalBytes) {
+            return false;
+        }
+        // В прямом порядке дети идут после родителя, так что циклов нет
+        for (uint32_t c = 0; c < record.childCount; c++) {
+            if (childList[record.firstChild + c] <= i) {
+                return false;
+            }
+        }
+    }
+
+    Interner& symbols = Interner::global();
+    std::vector<SymbolId> ids(header.symbolCount, NO_SYMBOL);
+    for (uint32_t i = 1; i < header.symbolCount; i++) {
+        ids[i] = symbols.intern(std::string_view(symbolBytes + offsets[i], offsets[i + 1] - offsets[i]));
+    }
+
+    ast = FlatAst();
+    ast.kind.reserve(header.nodeCount);
+    ast.loc.reserve(header.nodeCount);
+    ast.firstChild.reserve(header.nodeCount);
+    ast.childCount.reserve(header.nodeCount);
+    ast.subtreeEnd.reserve(header.nodeCount);
+    ast.payload.reserve(header.nodeCount);
+    for (uint32_t i = 0; i < header.nodeCount; i++) {
+        const AstNodeRecord& record = records[i];
+        FlatAst::Payload payload;
+        payload.name = ids[record.name];
+        payload.field = ids[record.field];
+        payload.typeName = ids[record.typeName];
+        payload.op = static_cast<TokenKind>(record.op);
+        payload.postfix = record.postfix != 0;
+        payload.literalKind = static_cast<ASTNode::LiteralKind>(record.literalKind);
+        payload.literalOffset = record.literalOffset;
+        payload.literalLength = record.literalLength;
+        ast.kind.push_back(static_cast<ASTNode::NodeType>(record.kind));
+        ast.loc.push_back(record.loc);
+        ast.firstChild.push_back(record.firstChild);
+        ast.childCount.push_back(record.childCount);
+        ast.subtreeEnd.push_back(record.subtreeEnd);
+        ast.payload.push_back(payload);
+    }
+    ast.childList.assign(childList, childList + header.childCount);
+    ast.strings.assign(symbolBytes + offsets[header.symbolCount], header.literalBytes);
+
+    lines.clear();
+    for (uint32_t i = 0; i < header.lineCount; i++) {
+        lines.addLine(lineStarts[i]);
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef AST_CACHE_HPP
+#define AST_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "flat_ast.hpp"
+#include "../Lab2/headers/source_loc.hpp"
+
+// Двоичный кэш дерева разбора (.mtast) рядом с исходником. Ключ - хеш
+// текста исходника, версии транслятора и режима разбора: при совпадении
+// ключа лексер и парсер не запускаются.
+//
+//   AstCacheHeader
+//   AstNodeRecord[nodeCount]             - узлы FlatAst в прямом порядке
+//   uint32_t childList[childCount]
+//   uint32_t lineStarts[lineCount]       - LineTable исходника
+//   uint32_t offsets[symbolCount + 1]    - таблица имён: смещения
+//   char symbolBytes[]                     и байты имён подряд
+//   char literalBytes[literalBytes]      - FlatAst::strings
+//
+// Имена в записях - номера в таблице имён файла (0 - нет имени); при
+// загрузке они заново добавляются в Interner::global(). Числа записываются
+// в порядке байтов машины, как в файле токенов.
+constexpr char AST_CACHE_MAGIC[4] = {'M', 'T', 'A', 'S'};
+constexpr uint32_t AST_CACHE_VERSION = 1;
+// Увеличивается при любом изменении парсера, меняющем дерево
+constexpr uint32_t TRANSLATOR_VERSION = 1;
+
+struct AstCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t nodeCount;
+    uint32_t childCount;
+    uint32_t lineCount;
+    uint32_t symbolCount;   // включая пустое имя с номером 0
+    uint32_t literalBytes;
+    uint32_t reserved;
+    uint64_t fileSize;
+};
+
+struct AstNodeRecord {
+    uint8_t kind;          // ASTNode::NodeType
+    uint8_t literalKind;   // ASTNode::LiteralKind
+    uint8_t op;            // TokenKind
+    uint8_t postfix;
+    SourceLoc loc;
+    uint32_t firstChild;
+    uint32_t childCount;
+    uint32_t subtreeEnd;
+    uint32_t name;         // номер в таблице имён
+    uint32_t field;
+    uint32_t typeName;
+    uint32_t literalOffset;
+    uint32_t literalLength;
+};
+
+static_assert(sizeof(AstCacheHeader) == 48, "заголовок кэша дерева должен быть 48 байт");
+static_assert(sizeof(AstNodeRecord) == 40, "запись узла должна быть 40 байт");
+
+// 64-битный FNV-1a; hash - результат для предыдущей части данных
+inline uint64_t fnv1a64(std::string_view data, uint64_t hash = 14695981039346656037ull) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Ключ кэша: предел глубины и ленивый разбор меняют получаемое дерево
+uint64_t astCacheKey(std::string_view source, uint64_t maxDepth, bool lazy);
+
+// Путь к кэшу: расширение исходника заменяется на .mtast
+std::string astCachePath(const std::string& sourcePath);
+
+bool saveAstCache(const std::string& path, uint64_t key, const FlatAst& ast, const LineTable& lines);
+
+// Разбирает отображённый файл кэша в ast и lines. Возвращает false, если
+// файл повреждён, другой версии или записан для другого ключа
+bool loadAstCache(std::string_view data, uint64_t key, FlatAst& ast, LineTable& lines);
+
+#endif // AST_CACHE_HPP
@@ -0,0 +1,190 @@
+#include "ast_dump.hpp"
+
+#include <charconv>
+#include <string>
+#include <vector>
+
+void DumpWriter::writeNumber(long long value) {
+    char digits[24];
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    write(std::string_view(digits, result.ptr - digits));
+}
+
+bool parseAstDumpFormat(std::string_view name, AstDumpFormat& format) {
+    if (name == "text") format = AstDumpFormat::TEXT;
+    else if (name == "json") format = AstDumpFormat::JSON;
+    else if (name == "dot") format = AstDumpFormat::DOT;
+    else return false;
+    return true;
+}
+
+namespace {
+
+struct Frame {
+    const ASTNode* node;
+    size_t next;          // следующий ребёнок
+    size_t prefixLength;  // длина префикса для детей узла (только TEXT)
+};
+
+// Строка узла: префикс рамки, тип и значения атрибутов через запятую
+void writeTextLine(const ASTNode* node, const std::string& prefix, bool isLast, DumpWriter& out) {
+    out.write(prefix);
+    out.write(isLast ? "└── " : "├── ");
+    out.write(node->toString());
+    out.write(": ");
+    for (const auto& attr : node->attributeList()) {
+        out.write(attr.second);
+        out.write(", ");
+    }
+    out.put('\n');
+}
+
+// Префикс рамки общий для всех кадров и обрезается при возврате вверх
+void dumpText(const ASTNode* root, DumpWriter& out) {
+    writeTextLine(root, "", true, out);
+    std::string path = "    ";
+    std::vector<Frame> stack;
+    stack.push_back({root, 0, path.size()});
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.next == frame.node->getChildCount()) {
+            stack.pop_back();
+            continue;
+        }
+        const ASTNode* child = frame.node->getChild(frame.next++);
+        bool last = frame.next == frame.node->getChildCount();
+        path.resize(frame.prefixLength);
+        writeTextLine(child, path, last, out);
+        if (child->getChildCount() > 0) {
+            path += last ? "    " : "│   ";
+            stack.push_back({child, 0, path.size()});
+        }
+    }
+}
+
+// Строка в кавычках с экранированием, общим для JSON и подписей DOT
+void writeQuoted(std::string_view text, DumpWriter& out) {
+    static const char hex[] = "0123456789abcdef";
+    out.put('"');
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out.put('\\');
+            out.put(c);
+        } else if (c == '\n') {
+            out.write("\\n");
+        } else if (c == '\t') {
+            out.write("\\t");
+        } else if (byte < 0x20) {
+            out.write("\\u00");
+            out.put(hex[byte >> 4]);
+            out.put(hex[byte & 15]);
+        } else {
+            out.put(c);
+        }
+    }
+    out.put('"');
+}
+
+void writeJsonNode(const ASTNode* node, DumpWriter& out) {
+    LineColumn position = LineTable::global().resolve(node->getLoc());
+    out.write("{\"type\":");
+    writeQuoted(node->toString(), out);
+    out.write(",\"line\":");
+    out.writeNumber(position.line);
+    out.write(",\"column\":");
+    out.writeNumber(position.column);
+    out.write(",\"attributes\":{");
+    bool first = true;
+    for (const auto& attr : node->attributeList()) {
+        if (!first) {
+            out.put(',');
+        }
+        first = false;
+        writeQuoted(attr.first, out);
+        out.put(':');
+        writeQuoted(attr.second, out);
+    }
+    out.write("},\"children\":[");
+}
+
+void dumpJson(const ASTNode* root, DumpWriter& out) {
+    std::vector<Frame> stack;
+    writeJsonNode(root, out);
+    stack.push_back({root, 0, 0});
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.next == frame.node->getChildCount()) {
+            out.write("]}");
+            stack.pop_back();
+            continue;
+        }
+        if (frame.next > 0) {
+            out.put(',');
+        }
+        const ASTNode* child = frame.node->getChild(frame.next++);
+        writeJsonNode(child, out);
+        stack.push_back({child, 0, 0});
+    }
+    out.put('\n');
+}
+
+// Вершина n<номер> с типом и атрибутами в подписи
+void writeDotNode(const ASTNode* node, size_t id, DumpWriter& out) {
+    std::string label = node->toString();
+    for (const auto& attr : node->attributeList()) {
+        label += '\n';
+        label += attr.first;
+        label += ": ";
+        label += attr.second;
+    }
+    out.write("  n");
+    out.writeNumber(static_cast<long long>(id));
+    out.write(" [label=");
+    writeQuoted(label, out);
+    out.write("];\n");
+}
+
+void dumpDot(const ASTNode* root, DumpWriter& out) {
+    struct DotFrame {
+        const ASTNode* node;
+        size_t id;
+    };
+    out.write("digraph AST {\n  node [shape=box, fontname=\"monospace\"];\n");
+    size_t nextId = 0;
+    std::vector<DotFrame> stack;
+    stack.push_back({root, nextId++});
+    while (!stack.empty()) {
+        DotFrame frame = stack.back();
+        stack.pop_back();
+        writeDotNode(frame.node, frame.id, out);
+        size_t count = frame.node->getChildCount();
+        size_t firstId = nextId;
+        nextId += count;
+        for (size_t i = 0; i < count; i++) {
+            out.write("  n");
+            out.writeNumber(static_cast<long long>(frame.id));
+            out.write(" -> n");
+            out.writeNumber(static_cast<long long>(firstId + i));
+            out.write(";\n");
+        }
+        for (size_t i = count; i-- > 0;) {
+            stack.push_back({frame.node->getChild(i), firstId + i});
+        }
+    }
+    out.write("}\n");
+}
+
+} // namespace
+
+void dumpAst(const ASTNode* root, AstDumpFormat format, DumpWriter& out) {
+    if (!root) {
+        return;
+    }
+    switch (format) {
+        case AstDumpFormat::TEXT: dumpText(root, out); break;
+        case AstDumpFormat::JSON: dumpJson(root, out); break;
+        case AstDumpFormat::DOT: dumpDot(root, out); break;
+    }
+    out.flush();
+}
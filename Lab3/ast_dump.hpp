@@ -0,0 +1,70 @@
+#ifndef AST_DUMP_HPP
+#define AST_DUMP_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include "utils.hpp"
+
+// Буферизованный вывод в FILE*: строки копируются в буфер и уходят в
+// файл одним fwrite, когда буфер заполнен, при flush() и в деструкторе
+class DumpWriter {
+public:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    explicit DumpWriter(std::FILE* file) : file(file), buffer(new char[BUFFER_SIZE]) {}
+    ~DumpWriter() { flush(); }
+
+    DumpWriter(const DumpWriter&) = delete;
+    DumpWriter& operator=(const DumpWriter&) = delete;
+
+    void write(std::string_view text) {
+        if (used + text.size() > BUFFER_SIZE) {
+            flush();
+            if (text.size() > BUFFER_SIZE) {
+                std::fwrite(text.data(), 1, text.size(), file);
+                return;
+            }
+        }
+        std::memcpy(buffer.get() + used, text.data(), text.size());
+        used += text.size();
+    }
+
+    void put(char c) {
+        if (used == BUFFER_SIZE) {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+
+    void writeNumber(long long value);
+
+    void flush() {
+        if (used > 0) {
+            std::fwrite(buffer.get(), 1, used, file);
+            used = 0;
+        }
+        std::fflush(file);
+    }
+
+private:
+    std::FILE* file;
+    std::unique_ptr<char[]> buffer;
+    size_t used = 0;
+};
+
+enum class AstDumpFormat {
+    TEXT,  // дерево с рамками, как прежний ASTNode::print
+    JSON,  // один объект на узел: type, line, column, attributes, children
+    DOT    // граф для Graphviz
+};
+
+// "text", "json" или "dot"; false для другого имени
+bool parseAstDumpFormat(std::string_view name, AstDumpFormat& format);
+
+// Обход с явным стеком, так что глубина дерева не ограничена стеком вызовов
+void dumpAst(const ASTNode* root, AstDumpFormat format, DumpWriter& out);
+
+#endif // AST_DUMP_HPP
@@ -0,0 +1,92 @@
+#include "flat_ast.hpp"
+
+FlatAst FlatAst::fromTree(const ASTNode* root) {
+    FlatAst flat;
+    if (!root) {
+        return flat;
+    }
+
+    // В стеке узел и место в childList, куда записать его номер
+    struct Pending {
+        const ASTNode* node;
+        uint32_t slot;
+    };
+    std::vector<Pending> stack;
+    // Открытые поддеревья: номер узла и сколько его потомков ещё не выписано
+    std::vector<std::pair<NodeIndex, size_t>> open;
+    stack.push_back({root, UINT32_MAX});
+
+    while (!stack.empty()) {
+        Pending current = stack.back();
+        stack.pop_back();
+        const ASTNode* node = current.node;
+        NodeIndex index = static_cast<NodeIndex>(flat.kind.size());
+        if (current.slot != UINT32_MAX) {
+            flat.childList[current.slot] = index;
+        }
+
+        Payload data;
+        data.name = node->getName();
+        data.field = node->getField();
+        data.typeName = node->getTypeName();
+        data.op = node->getOperator();
+        data.postfix = node->isPostfix();
+        data.literalKind = node->getLiteralKind();
+        std::string_view text = node->getLiteralText();
+        data.literalOffset = static_cast<uint32_t>(flat.strings.size());
+        data.literalLength = static_cast<uint32_t>(text.size());
+        flat.strings.append(text);
+
+        size_t count = node->getChildCount();
+        flat.kind.push_back(node->getType());
+        flat.loc.push_back(node->getLoc());
+        flat.firstChild.push_back(static_cast<uint32_t>(flat.childList.size()));
+        flat.childCount.push_back(static_cast<uint32_t>(count));
+        flat.subtreeEnd.push_back(NO_NODE);
+        flat.payload.push_back(data);
+
+        uint32_t first = static_cast<uint32_t>(flat.childList.size());
+        flat.childList.resize(first + count, NO_NODE);
+        for (size_t i = count; i-- > 0;) {
+            stack.push_back({node->getChild(i), static_cast<uint32_t>(first + i)});
+        }
+
+        // Узел выписан: у предков стало на одного невыписанного потомка меньше
+        NodeIndex end = index + 1;
+        if (count > 0) {
+            open.push_back({index, count});
+            continue;
+        }
+        flat.subtreeEnd[index] = end;
+        while (!open.empty() && --open.back().second == 0) {
+            flat.subtreeEnd[open.back().first] = end;
+            open.pop_back();
+        }
+    }
+    return flat;
+}
+
+ASTNode* FlatAst::toTree(AstArena& arena) const {
+    if (empty()) {
+        return nullptr;
+    }
+    std::vector<ASTNode*> nodes(size());
+    for (NodeIndex i = 0; i < size(); i++) {
+        ASTNode* node = arena.create<ASTNode>(kind[i], loc[i], arena);
+        const Payload& data = payload[i];
+        node->setName(data.name);
+        node->setField(data.field);
+        node->setTypeName(data.typeName);
+        node->setOperator(data.op, data.postfix);
+        if (data.literalKind != ASTNode::NO_LITERAL) {
+            node->setLiteral(data.literalKind, literalText(i));
+        }
+        nodes[i] = node;
+    }
+    for (NodeIndex i = 0; i < size(); i++) {
+        for (uint32_t c = 0; c < childCount[i]; c++) {
+            nodes[i]->addChild(nodes[childList[firstChild[i] + c]]);
+        }
+    }
+    return nodes[0];
+}
@@ -0,0 +1,130 @@
+#ifndef FLAT_AST_HPP
+#define FLAT_AST_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "utils.hpp"
+
+// Номер узла в FlatAst; узлы пронумерованы в прямом порядке обхода
+using NodeIndex = uint32_t;
+constexpr NodeIndex NO_NODE = UINT32_MAX;
+
+class FlatAst;
+
+// Лёгкая ссылка на узел FlatAst с теми же методами чтения, что у ASTNode,
+// чтобы проходы можно было переводить на плоское дерево постепенно
+class FlatNode {
+public:
+    FlatNode(const FlatAst* ast, NodeIndex index) : ast(ast), index(index) {}
+
+    NodeIndex getIndex() const { return index; }
+    explicit operator bool() const { return ast && index != NO_NODE; }
+
+    ASTNode::NodeType getType() const;
+    SourceLoc getLoc() const;
+    size_t getChildCount() const;
+    FlatNode getChild(size_t i) const;
+
+    SymbolId getName() const;
+    std::string_view getNameText() const;
+    SymbolId getField() const;
+    std::string_view getFieldText() const;
+    SymbolId getTypeName() const;
+    std::string_view getTypeNameText() const;
+    TokenKind getOperator() const;
+    std::string_view getOperatorText() const;
+    bool isPostfix() const;
+    ASTNode::LiteralKind getLiteralKind() const;
+    std::string_view getLiteralText() const;
+
+private:
+    const FlatAst* ast;
+    NodeIndex index;
+};
+
+// Дерево разбора в виде параллельных массивов. Узлы лежат в прямом
+// порядке обхода, поэтому проход по всему дереву - последовательный
+// просмотр массивов. Дети узла - непрерывный отрезок массива childList,
+// поддерево узла - отрезок [index, subtreeEnd). Все массивы состоят из
+// чисел, а строки литералов собраны в один буфер, так что дерево легко
+// записать в файл целиком.
+//
+// Переносятся типизированные поля узлов; произвольные атрибуты из
+// setAttribute в плоское дерево не попадают.
+class FlatAst {
+public:
+    struct Payload {
+        SymbolId name = NO_SYMBOL;
+        SymbolId field = NO_SYMBOL;
+        SymbolId typeName = NO_SYMBOL;
+        TokenKind op = TK_NONE;
+        bool postfix = false;
+        ASTNode::LiteralKind literalKind = ASTNode::NO_LITERAL;
+        uint32_t literalOffset = 0; // в strings
+        uint32_t literalLength = 0;
+    };
+
+    static FlatAst fromTree(const ASTNode* root);
+    // Обратное преобразование для проходов, которые работают с ASTNode
+    ASTNode* toTree(AstArena& arena) const;
+
+    size_t size() const { return kind.size(); }
+    bool empty() const { return kind.empty(); }
+    FlatNode root() const { return FlatNode(this, empty() ? NO_NODE : 0); }
+    FlatNode node(NodeIndex index) const { return FlatNode(this, index); }
+
+    NodeIndex child(NodeIndex index, size_t i) const {
+        return i < childCount[index] ? childList[firstChild[index] + i] : NO_NODE;
+    }
+
+    std::string_view literalText(NodeIndex index) const {
+        return std::string_view(strings).substr(payload[index].literalOffset, payload[index].literalLength);
+    }
+
+    // Обход всех узлов в прямом порядке без стека и переходов по указателям
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (NodeIndex i = 0; i < size(); i++) {
+            visit(FlatNode(this, i));
+        }
+    }
+
+    std::vector<ASTNode::NodeType> kind;
+    std::vector<SourceLoc> loc;
+    std::vector<uint32_t> firstChild; // начало отрезка в childList
+    std::vector<uint32_t> childCount;
+    std::vector<NodeIndex> subtreeEnd; // первый узел после поддерева
+    std::vector<Payload> payload;
+    std::vector<NodeIndex> childList;
+    std::string strings;              // тексты литералов подряд
+};
+
+inline ASTNode::NodeType FlatNode::getType() const { return ast->kind[index]; }
+inline SourceLoc FlatNode::getLoc() const { return ast->loc[index]; }
+inline size_t FlatNode::getChildCount() const { return ast->childCount[index]; }
+inline FlatNode FlatNode::getChild(size_t i) const { return FlatNode(ast, ast->child(index, i)); }
+
+inline SymbolId FlatNode::getName() const { return ast->payload[index].name; }
+inline SymbolId FlatNode::getField() const { return ast->payload[index].field; }
+inline SymbolId FlatNode::getTypeName() const { return ast->payload[index].typeName; }
+inline TokenKind FlatNode::getOperator() const { return ast->payload[index].op; }
+inline std::string_view FlatNode::getOperatorText() const { return kindText(getOperator()); }
+inline bool FlatNode::isPostfix() const { return ast->payload[index].postfix; }
+inline ASTNode::LiteralKind FlatNode::getLiteralKind() const { return ast->payload[index].literalKind; }
+inline std::string_view FlatNode::getLiteralText() const { return ast->literalText(index); }
+
+inline std::string_view FlatNode::getNameText() const {
+    return getName() == NO_SYMBOL ? std::string_view() : Interner::global().name(getName());
+}
+
+inline std::string_view FlatNode::getFieldText() const {
+    return getField() == NO_SYMBOL ? std::string_view() : Interner::global().name(getField());
+}
+
+inline std::string_view FlatNode::getTypeNameText() const {
+    return getTypeName() == NO_SYMBOL ? std::string_view() : Interner::global().name(getTypeName());
+}
+
+#endif // FLAT_AST_HPP
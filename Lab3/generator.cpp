@@ -107,8 +107,83 @@ std::string CodeGenerator::generate(ASTNode* root) {
     return result.str();
 }
 
-void CodeGenerator::generateCode(ASTNode* node) {
-    if (!node) return;
+// Обход дерева без рекурсии: шаги лежат на стеке work. Генератор узла
+// выводит текст сразу, пока не запросил ни одного дочернего узла, а всё
+// после первого visit откладывает в pending; pending затем кладётся на
+// стек в обратном порядке, чтобы выполниться раньше оставшихся шагов
+void CodeGenerator::generateCode(ASTNode* root) {
+    work.clear();
+    pending.clear();
+    if (root) work.push_back({Step::NODE, root, {}});
+    while (!work.empty()) {
+        Step step = std::move(work.back());
+        work.pop_back();
+        switch (step.kind) {
+            case Step::TEXT:
+                code << step.text;
+                break;
+            case Step::INDENTATION:
+                code << indentation;
+                break;
+            case Step::INDENT:
+                increaseIndent();
+                break;
+            case Step::DEDENT:
+                decreaseIndent();
+                break;
+            case Step::STATEMENT:
+                statementExpression = step.node;
+                generateNode(step.node);
+                break;
+            case Step::NODE:
+                generateNode(step.node);
+                break;
+        }
+        work.insert(work.end(), std::make_move_iterator(pending.rbegin()),
+                    std::make_move_iterator(pending.rend()));
+        pending.clear();
+    }
+}
+
+void CodeGenerator::schedule(Step::Kind kind, ASTNode* node, std::string_view text) {
+    if (pending.empty() && kind != Step::NODE && kind != Step::STATEMENT) {
+        switch (kind) {
+            case Step::TEXT: code << text; break;
+            case Step::INDENTATION: code << indentation; break;
+            case Step::INDENT: increaseIndent(); break;
+            default: decreaseIndent(); break;
+        }
+        return;
+    }
+    pending.push_back({kind, node, std::string(text)});
+}
+
+void CodeGenerator::emit(std::string_view text) {
+    schedule(Step::TEXT, nullptr, text);
+}
+
+void CodeGenerator::emitIndentation() {
+    schedule(Step::INDENTATION);
+}
+
+void CodeGenerator::indent() {
+    schedule(Step::INDENT);
+}
+
+void CodeGenerator::dedent() {
+    schedule(Step::DEDENT);
+}
+
+void CodeGenerator::visit(ASTNode* node) {
+    if (node) schedule(Step::NODE, node);
+}
+
+// Корень оператора-выражения: присваивание в нём выводится без скобок
+void CodeGenerator::visitStatementExpression(ASTNode* node) {
+    if (node) schedule(Step::STATEMENT, node);
+}
+
+void CodeGenerator::generateNode(ASTNode* node) {
 
     switch (node->getType()) {
         case ASTNode::PROGRAM:
@@ -165,6 +240,9 @@ void CodeGenerator::generateCode(ASTNode* node) {
         case ASTNode::UNARY_EXPR:
             generateUnaryExpression(node);
             break;
+        case ASTNode::CONDITIONAL_EXPR:
+            generateConditionalExpression(node);
+            break;
         case ASTNode::LITERAL:
             generateLiteral(node);
             break;
@@ -181,10 +259,12 @@ void CodeGenerator::generateCode(ASTNode* node) {
             generateAssignment(node);
             break;
         case ASTNode::BREAK_STMT:
-            code << indentation << "break;" << std::endl;
+            emitIndentation();
+            emit("break;\n");
             break;
         case ASTNode::CONTINUE_STMT:
-            code << indentation << "continue;" << std::endl;
+            emitIndentation();
+            emit("continue;\n");
             break;
         default:
             std::cerr << "Неизвестный тип узла в генерации кода: " << node->getType() << std::endl;
@@ -194,7 +274,7 @@ void CodeGenerator::generateCode(ASTNode* node) {
 
 void CodeGenerator::generateProgram(ASTNode* node) {
     for (size_t i = 0; i < node->getChildCount(); ++i) {
-        generateCode(node->getChild(i));
+        visit(node->getChild(i));
     }
 }
 
@@ -206,50 +286,52 @@ void CodeGenerator::generateClassDeclaration(ASTNode* node) {
         if (child->getType() == ASTNode::BLOCK) {
             // Обрабатываем детей блока, пропуская сам блок
             for (size_t j = 0; j < child->getChildCount(); ++j) {
-                generateCode(child->getChild(j));
+                visit(child->getChild(j));
             }
         } else {
-            generateCode(child);
+            visit(child);
         }
     }
 }
 
 void CodeGenerator::generateMethodDeclaration(ASTNode* node) {
-    std::string methodName = node->getAttribute("name");
-    std::string returnType = node->getAttribute("returnType");
+    std::string_view methodName = node->getNameText();
     
     // Преобразуем возвращаемый тип из Java в C++
-    std::string cppReturnType = mapType(returnType);
+    std::string cppReturnType = mapType(std::string(node->getTypeNameText()));
     
     // Особая обработка для main
     if (methodName == "main") {
-        code << "int main(int argc, char* argv[])" << std::endl;
+        emit("int main(int argc, char* argv[])\n");
     } else {
-        code << cppReturnType << " " << methodName << "(";
+        emit(cppReturnType);
+        emit(" ");
+        emit(methodName);
+        emit("(");
         
         // Генерация параметров
         for (size_t i = 0; i < node->getChildCount(); ++i) {
             if (node->getChild(i)->getType() == ASTNode::PARAMETER_LIST) {
                 ASTNode* paramList = node->getChild(i);
                 for (size_t j = 0; j < paramList->getChildCount(); ++j) {
-                    if (j > 0) code << ", ";
+                    if (j > 0) emit(", ");
                     
                     ASTNode* param = paramList->getChild(j);
-                    std::string paramName = param->getAttribute("name");
-                    std::string paramType = param->getAttribute("type");
-                    code << mapType(paramType) << " " << paramName;
+                    emit(mapType(std::string(param->getTypeNameText())));
+                    emit(" ");
+                    emit(param->getNameText());
                 }
             }
         }
         
-        code << ")" << std::endl;
+        emit(")\n");
     }
     
     // Генерация тела метода
     for (size_t i = 0; i < node->getChildCount(); ++i) {
         ASTNode* child = node->getChild(i);
         if (child->getType() == ASTNode::BLOCK) {
-            generateCode(child);
+            visit(child);
         }
     }
     
@@ -282,20 +364,21 @@ void CodeGenerator::generateMethodDeclaration(ASTNode* node) {
 }
 
 void CodeGenerator::generateBlock(ASTNode* node) {
-    code << "{" << std::endl;
-    increaseIndent();
+    emit("{\n");
+    indent();
     
     for (size_t i = 0; i < node->getChildCount(); ++i) {
-        generateCode(node->getChild(i));
+        visit(node->getChild(i));
     }
     
-    decreaseIndent();
-    code << indentation << "}" << std::endl;
+    dedent();
+    emitIndentation();
+    emit("}\n");
 }
 
 void CodeGenerator::generateVariableDeclaration(ASTNode* node) {
-    std::string varName = node->getAttribute("name");
-    std::string varType = node->getAttribute("type");
+    std::string_view varName = node->getNameText();
+    std::string varType(node->getTypeNameText());
     
     // Специальная обработка для ArrayList и HashMap
     if (varType.find("ArrayList") != std::string::npos) {
@@ -306,14 +389,17 @@ void CodeGenerator::generateVariableDeclaration(ASTNode* node) {
         if (start != std::string::npos && end != std::string::npos) {
             elemType = varType.substr(start + 1, end - start - 1);
         }
-        code << "std::vector<" << mapType(elemType) << "> " << varName;
+        emit("std::vector<");
+        emit(mapType(elemType));
+        emit("> ");
+        emit(varName);
         
         // По умолчанию инициализируем, если нет инициализатора
         if (node->getChildCount() == 0) {
             // code << "()";
         } else {
-            code << " = ";
-            generateCode(node->getChild(0));
+            emit(" = ");
+            visit(node->getChild(0));
         }
     } else if (varType.find("HashMap") != std::string::npos) {
         includes.insert("#include <unordered_map>");
@@ -337,35 +423,42 @@ void CodeGenerator::generateVariableDeclaration(ASTNode* node) {
                 valueType = valueType.substr(valueStart, valueEnd - valueStart + 1);
             }
         }
-        code << "std::unordered_map<" << mapType(keyType) << ", " << mapType(valueType) << "> " << varName;
+        emit("std::unordered_map<");
+        emit(mapType(keyType));
+        emit(", ");
+        emit(mapType(valueType));
+        emit("> ");
+        emit(varName);
         
         // По умолчанию инициализируем, если нет инициализатора
         if (node->getChildCount() == 0) {
             // code << "()";
         } else {
-            code << " = ";
-            generateCode(node->getChild(0));
+            emit(" = ");
+            visit(node->getChild(0));
         }
     } else {
         // Обычное объявление переменной
         // code << indentation << mapType(varType) << " " << varName;
-        code << mapType(varType) << " " << varName;
+        emit(mapType(varType));
+        emit(" ");
+        emit(varName);
         
         // Если есть инициализатор
         if (node->getChildCount() > 0) {
             if (node->getChild(0)->getType() == ASTNode::ARRAY_INIT) {
                 // Инициализация массива
-                code << " = {";
+                emit(" = {");
                 ASTNode* arrayInit = node->getChild(0);
                 for (size_t i = 0; i < arrayInit->getChildCount(); ++i) {
-                    if (i > 0) code << ", ";
-                    generateCode(arrayInit->getChild(i));
+                    if (i > 0) emit(", ");
+                    visit(arrayInit->getChild(i));
                 }
-                code << "}";
+                emit("}");
             } else {
                 // Обычная инициализация
-                code << " = ";
-                generateCode(node->getChild(0));
+                emit(" = ");
+                visit(node->getChild(0));
             }
         }
     }
@@ -374,146 +467,158 @@ void CodeGenerator::generateVariableDeclaration(ASTNode* node) {
 }
 
 void CodeGenerator::generateArrayInitialization(ASTNode* node) {
-    code << "{";
+    emit("{");
     for (size_t i = 0; i < node->getChildCount(); ++i) {
-        if (i > 0) code << ", ";
-        generateCode(node->getChild(i));
+        if (i > 0) emit(", ");
+        visit(node->getChild(i));
     }
-    code << "}";
+    emit("}");
 }
 
 void CodeGenerator::generateIfStatement(ASTNode* node) {
-    code << indentation << "if (";
-    generateCode(node->getChild(0)); // Условие
-    code << ") ";
+    emitIndentation();
+    emit("if (");
+    visit(node->getChild(0)); // Условие
+    emit(") ");
     
     // Ветка then
-    generateCode(node->getChild(1));
+    visit(node->getChild(1));
     
     // Ветка else (если есть)
     if (node->getChildCount() > 2) {
-        code << indentation << "else ";
-        generateCode(node->getChild(2));
+        emitIndentation();
+        emit("else ");
+        visit(node->getChild(2));
     }
 }
 
 void CodeGenerator::generateWhileLoop(ASTNode* node) {
-    code << indentation << "while (";
-    generateCode(node->getChild(0)); // Условие
-    code << ") ";
+    emitIndentation();
+    emit("while (");
+    visit(node->getChild(0)); // Условие
+    emit(") ");
     
     // Тело
-    generateCode(node->getChild(1));
+    visit(node->getChild(1));
 }
 
 void CodeGenerator::generateDoWhileLoop(ASTNode* node) {
-    code << indentation << "do ";
+    emitIndentation();
+    emit("do ");
     
     // Тело
-    generateCode(node->getChild(0));
+    visit(node->getChild(0));
     
-    code << indentation << "while (";
-    generateCode(node->getChild(1)); // Условие
-    code << ");" << std::endl;
+    emitIndentation();
+    emit("while (");
+    visit(node->getChild(1)); // Условие
+    emit(");\n");
 }
 
 void CodeGenerator::generateForLoop(ASTNode* node) {
-    code << indentation << "for (";
+    emitIndentation();
+    emit("for (");
     
     // Инициализация
     if (node->getChild(0)->getType() == ASTNode::VARIABLE_DECL) {
-        std::string varName = node->getChild(0)->getAttribute("name");
-        std::string varType = node->getChild(0)->getAttribute("type");
+        std::string_view varName = node->getChild(0)->getNameText();
+        std::string varType(node->getChild(0)->getTypeNameText());
         
-        code << mapType(varType) << " " << varName;
+        emit(mapType(varType));
+        emit(" ");
+        emit(varName);
         
         if (node->getChild(0)->getChildCount() > 0) {
-            code << " = ";
-            generateCode(node->getChild(0)->getChild(0));
+            emit(" = ");
+            visit(node->getChild(0)->getChild(0));
         }
     } else {
-        generateCode(node->getChild(0));
+        visit(node->getChild(0));
     }
     
-    code << "; ";
+    emit("; ");
     
     // Условие
-    generateCode(node->getChild(1));
+    visit(node->getChild(1));
     
-    code << "; ";
+    emit("; ");
     
     // Обновление
-    generateCode(node->getChild(2));
+    visitStatementExpression(node->getChild(2));
     
-    code << ") ";
+    emit(") ");
     
     // Тело
-    generateCode(node->getChild(3));
+    visit(node->getChild(3));
 }
 
 void CodeGenerator::generateSwitchStatement(ASTNode* node) {
-    code << indentation << "switch (";
-    generateCode(node->getChild(0)); // Выражение switch
-    code << ") {" << std::endl;
+    emitIndentation();
+    emit("switch (");
+    visit(node->getChild(0)); // Выражение switch
+    emit(") {\n");
     
     // Case операторы обрабатываются дочерними узлами
     for (size_t i = 1; i < node->getChildCount(); ++i) {
-        generateCode(node->getChild(i));
+        visit(node->getChild(i));
     }
     
-    code << indentation << "}" << std::endl;
+    emitIndentation();
+    emit("}\n");
 }
 
 void CodeGenerator::generateCase(ASTNode* node) {
-    code << indentation << "case ";
-    generateCode(node->getChild(0)); // Значение case
-    code << ":" << std::endl;
+    emitIndentation();
+    emit("case ");
+    visit(node->getChild(0)); // Значение case
+    emit(":\n");
     
-    increaseIndent();
+    indent();
     
     // Тело case
     for (size_t i = 1; i < node->getChildCount(); ++i) {
-        generateCode(node->getChild(i));
+        visit(node->getChild(i));
     }
     
-    decreaseIndent();
+    dedent();
 }
 
 void CodeGenerator::generateDefault(ASTNode* node) {
-    code << indentation << "default:" << std::endl;
+    emitIndentation();
+    emit("default:\n");
     
-    increaseIndent();
+    indent();
     
     // Тело default
     for (size_t i = 0; i < node->getChildCount(); ++i) {
-        generateCode(node->getChild(i));
+        visit(node->getChild(i));
     }
     
-    decreaseIndent();
+    dedent();
 }
 
 void CodeGenerator::generateReturnStatement(ASTNode* node) {
-    code << "return";
+    emit("return");
     
     if (node->getChildCount() > 0) {
-        code << " ";
-        generateCode(node->getChild(0));
+        emit(" ");
+        visit(node->getChild(0));
     }
     
     // code << ";" << std::endl;
 }
 
 void CodeGenerator::generateMethodCall(ASTNode* node) {
-    std::string methodName = node->getAttribute("name");
+    std::string_view methodName = node->getNameText();
     
     // Специальная обработка для System.out.println
     if (methodName == "System.out.println") {
-        code << "std::cout";
+        emit("std::cout");
         for (size_t i = 0; i < node->getChildCount(); ++i) {
-            code << " << ";
-            generateCode(node->getChild(i));
+            emit(" << ");
+            visit(node->getChild(i));
         }
-        code << " << std::endl";
+        emit(" << std::endl");
         // code << indentation << "std::cout << ";
         
         // if (node->getChildCount() > 0) {
@@ -526,132 +631,156 @@ void CodeGenerator::generateMethodCall(ASTNode* node) {
         // Вызов метода на объекте через field access
         ASTNode* fieldAccess = node->getChild(0);
         
-        std::string objField = fieldAccess->getAttribute("field");
+        std::string_view objField = fieldAccess->getFieldText();
         
         // Специальные методы для контейнеров
         if (objField == "add" || objField == "push") {
-            generateCode(fieldAccess->getChild(0));
-            code << ".push_back(";
+            visit(fieldAccess->getChild(0));
+            emit(".push_back(");
             
             if (node->getChildCount() > 1) {
-                generateCode(node->getChild(1));
+                visit(node->getChild(1));
             }
             
-            code << ")";
+            emit(")");
         } else if (objField == "get") {
-            generateCode(fieldAccess->getChild(0));
-            code << "[";
+            visit(fieldAccess->getChild(0));
+            emit("[");
             
             if (node->getChildCount() > 1) {
-                generateCode(node->getChild(1));
+                visit(node->getChild(1));
             }
             
-            code << "]";
+            emit("]");
         } else if (objField == "put") {
-            generateCode(fieldAccess->getChild(0));
-            code << "[";
+            visit(fieldAccess->getChild(0));
+            emit("[");
             
             if (node->getChildCount() > 1) {
-                generateCode(node->getChild(1));
+                visit(node->getChild(1));
             }
             
-            code << "] = ";
+            emit("] = ");
             
             if (node->getChildCount() > 2) {
-                generateCode(node->getChild(2));
+                visit(node->getChild(2));
             }
             // code << ";\n";
         } else if (objField == "size") {
-            generateCode(fieldAccess->getChild(0));
-            code << ".size()";
+            visit(fieldAccess->getChild(0));
+            emit(".size()");
         } else {
             // Стандартный вызов метода
-            generateCode(fieldAccess->getChild(0));
-            code << "." << objField << "(";
+            visit(fieldAccess->getChild(0));
+            emit(".");
+            emit(objField);
+            emit("(");
             
             for (size_t i = 1; i < node->getChildCount(); ++i) {
-                if (i > 1) code << ", ";
-                generateCode(node->getChild(i));
+                if (i > 1) emit(", ");
+                visit(node->getChild(i));
             }
             
-            code << ")";
+            emit(")");
         }
     } else {
         // Обычный вызов метода
         if (!methodName.empty()) {
-            code << methodName << "(";
+            emit(methodName);
+            emit("(");
         } else {
-            code << "(";
+            emit("(");
         }
         
         // Аргументы
         for (size_t i = 0; i < node->getChildCount(); ++i) {
-            if (i > 0) code << ", ";
-            generateCode(node->getChild(i));
+            if (i > 0) emit(", ");
+            visit(node->getChild(i));
         }
         
-        code << ")";
+        emit(")");
     }
 }
 
 void CodeGenerator::generateExpressionStatement(ASTNode* node) {
-    code << indentation;
-    generateCode(node->getChild(0));
-    code << ";" << std::endl;
+    emitIndentation();
+    visitStatementExpression(node->getChild(0));
+    emit(";\n");
 }
 
-void CodeGenerator::generateBinaryExpression(ASTNode* node) {
-    std::string op = node->getAttribute("operator");
+// Части записи бинарного оператора: открывающая перед левым операндом,
+// между операндами и закрывающая после правого
+CodeGenerator::BinaryParts CodeGenerator::binaryParts(ASTNode* node) {
+    TokenKind op = node->getOperator();
     
-    if (op == "+") {
-        bool leftIsString = node->getChild(0)->getAttribute("literalType") == "string";
-        bool rightIsString = node->getChild(1)->getAttribute("literalType") == "string";
+    if (op == PLUS) {
+        bool leftIsString = node->getChild(0)->getLiteralKind() == ASTNode::STRING_LITERAL;
+        bool rightIsString = node->getChild(1)->getLiteralKind() == ASTNode::STRING_LITERAL;
         
         // Если хотя бы один операнд строка - генерируем через операторы потока
         if (leftIsString || rightIsString) {
-            generateCode(node->getChild(0));
-            code << " << ";
-            generateCode(node->getChild(1));
-            return;
+            return {"", " << ", ""};
         }
     }
 
-    // Обработка специальных случаев для операторов типа Java +=
-    if (op == "+=" || op == "-=" || op == "*=" || op == "/=") {
-        generateCode(node->getChild(0));
-        code << " " << op << " ";
-        generateCode(node->getChild(1));
-        return;
+    // Присваивание без скобок только на верхнем уровне оператора-выражения:
+    // операндом оно связывает слабее соседних операторов C++
+    if (op == ASSIGN || op == PLUS_ASSIGN || op == MINUS_ASSIGN || op == STAR_ASSIGN ||
+        op == SLASH_ASSIGN || op == PERCENT_ASSIGN) {
+        if (node == statementExpression) {
+            return {"", " " + std::string(node->getOperatorText()) + " ", ""};
+        }
+        return {"(", " " + std::string(node->getOperatorText()) + " ", ")"};
     }
     
-    code << "(";
-    generateCode(node->getChild(0)); // Левый операнд
-    
-    code << " " << op << " ";
-    
-    generateCode(node->getChild(1)); // Правый операнд
-    code << ")";
+    // В C++ нет >>>: беззнаковый сдвиг через приведение к unsigned
+    if (op == UNSIGNED_SHIFT_RIGHT) {
+        return {"static_cast<int>(static_cast<unsigned int>(", ") >> ", ")"};
+    }
+
+    return {"(", " " + std::string(node->getOperatorText()) + " ", ")"};
+}
+
+void CodeGenerator::generateBinaryExpression(ASTNode* node) {
+    BinaryParts parts = binaryParts(node);
+    emit(parts.open);
+    visit(node->getChild(0));
+    emit(parts.middle);
+    visit(node->getChild(1));
+    emit(parts.close);
 }
 
 void CodeGenerator::generateUnaryExpression(ASTNode* node) {
-    std::string op = node->getAttribute("operator");
-    
-    if (op == "++" || op == "--") {
-        // По умолчанию считаем префиксным
-        code << op;
-        generateCode(node->getChild(0));
+    std::string_view op = node->getOperatorText();
+    
+    if (node->isPostfix()) {
+        visit(node->getChild(0));
+        emit(op);
+    } else if (node->getOperator() == PLUS_PLUS || node->getOperator() == MINUS_MINUS) {
+        emit(op);
+        visit(node->getChild(0));
     } else {
-        code << op;
-        generateCode(node->getChild(0));
+        emit(op);
+        visit(node->getChild(0));
     }
 }
 
+void CodeGenerator::generateConditionalExpression(ASTNode* node) {
+    emit("(");
+    visit(node->getChild(0));
+    emit(" ? ");
+    visit(node->getChild(1));
+    emit(" : ");
+    visit(node->getChild(2));
+    emit(")");
+}
+
 void CodeGenerator::generateLiteral(ASTNode* node) {
-    std::string literalType = node->getAttribute("literalType");
-    std::string value = node->getAttribute("value");
+    ASTNode::LiteralKind literalType = node->getLiteralKind();
+    std::string_view value = node->getLiteralText();
     
-    if (literalType == "string") {
-        code << value;  // Теперь просто выводим строку без преобразований
+    if (literalType == ASTNode::STRING_LITERAL) {
+        emit(value);  // Теперь просто выводим строку без преобразований
     // }
     // if (literalType == "string") {
     //     // Удаляем кавычки, если они есть
@@ -660,44 +789,43 @@ void CodeGenerator::generateLiteral(ASTNode* node) {
     //     } else {
     //         code << "\"" << value << "\"";
     //     }
-    } else if (literalType == "char") {
-        code << value;
-    } else if (literalType == "boolean") {
+    } else if (literalType == ASTNode::CHAR_LITERAL) {
+        emit(value);
+    } else if (literalType == ASTNode::BOOLEAN_LITERAL) {
         // В C++ литералы булевого типа в нижнем регистре
-        if (value == "true" || value == "True") {
-            code << "true";
-        } else if (value == "false" || value == "False") {
-            code << "false";
-        } else {
-            code << value;
-        }
+        emit((node->getBoolValue() ? "true" : "false"));
+    } else if (literalType == ASTNode::INT_LITERAL && value.find('_') != std::string_view::npos) {
+        // 1_000 в Java - это 1'000 в C++
+        std::string digits(value);
+        std::replace(digits.begin(), digits.end(), '_', '\'');
+        emit(digits);
     } else {
-        code << value;
+        emit(value);
     }
 }
 
 void CodeGenerator::generateVariable(ASTNode* node) {
-    code << node->getAttribute("name");
+    emit(node->getNameText());
 }
 
 void CodeGenerator::generateArrayAccess(ASTNode* node) {
-    generateCode(node->getChild(0)); // Массив
-    code << "[";
-    generateCode(node->getChild(1)); // Индекс
-    code << "]";
+    visit(node->getChild(0)); // Массив
+    emit("[");
+    visit(node->getChild(1)); // Индекс
+    emit("]");
 }
 
 void CodeGenerator::generateFieldAccess(ASTNode* node) {
     // Генерируем объект только если это реальный доступ к объекту
     if (node->getChildCount() > 0) {
-        generateCode(node->getChild(0)); // Объект
-        code << ".";
+        visit(node->getChild(0)); // Объект
+        emit(".");
     }
-    code << node->getAttribute("field");
+    emit(node->getFieldText());
 }
 
 void CodeGenerator::generateAssignment(ASTNode* node) {
-    generateCode(node->getChild(0)); // Цель
-    code << " = ";
-    generateCode(node->getChild(1)); // Значение
+    visit(node->getChild(0)); // Цель
+    emit(" = ");
+    visit(node->getChild(1)); // Значение
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <set>
 #include <map>
 #include <vector>
+#include <string_view>
+#include <iterator>
 #include "utils.hpp"
 // class ASTNode;  // Forward declaration
 
@@ -16,12 +18,31 @@ private:
     std::string indentation;
     int indentLevel;
     std::map<std::string, std::string> typeMap;
+    // Корень выражения текущего оператора-выражения или обновления for
+    const ASTNode* statementExpression = nullptr;
 
     void increaseIndent();
     void decreaseIndent();
     std::string mapType(const std::string& javaType);
     void initTypeMap();
-    void generateCode(ASTNode* node);
+    // Шаг обхода: вывод текста или отступа, смена отступа либо узел дерева
+    struct Step {
+        enum Kind { TEXT, INDENTATION, INDENT, DEDENT, NODE, STATEMENT } kind;
+        ASTNode* node;
+        std::string text;
+    };
+    std::vector<Step> work;
+    std::vector<Step> pending;
+
+    void generateCode(ASTNode* root);
+    void schedule(Step::Kind kind, ASTNode* node = nullptr, std::string_view text = {});
+    void emit(std::string_view text);
+    void emitIndentation();
+    void indent();
+    void dedent();
+    void visit(ASTNode* node);
+    void visitStatementExpression(ASTNode* node);
+    void generateNode(ASTNode* node);
     
     // Code generation methods
     void generateProgram(ASTNode* node);
@@ -41,7 +62,14 @@ private:
     void generateMethodCall(ASTNode* node);
     void generateExpressionStatement(ASTNode* node);
     void generateBinaryExpression(ASTNode* node);
+    struct BinaryParts {
+        const char* open;
+        std::string middle;
+        const char* close;
+    };
+    BinaryParts binaryParts(ASTNode* node);
     void generateUnaryExpression(ASTNode* node);
+    void generateConditionalExpression(ASTNode* node);
     void generateLiteral(ASTNode* node);
     void generateVariable(ASTNode* node);
     void generateArrayAccess(ASTNode* node);
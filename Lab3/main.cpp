@@ -1,40 +1,27 @@
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <thread>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 #include <chrono>
+#include <string_view>
+#include <charconv>
+#include <cctype>
+#include <cstring>
 #include "utils.hpp"
 #include "generator.hpp"
-
-enum TokenType {
-    KEYWORD,
-    IDENTIFIER,
-    NUMBER,
-    FLOAT_NUMBER,
-    STRING_LITERAL,
-    CHAR_LITERAL,
-    OPERATOR,
-    ERROR
-};
-
-struct Token {
-    TokenType type;
-    std::string lexeme;
-    int line;
-
-    std::string toString(){
-        if (type == KEYWORD) return "KEYWORD";
-            else if (type == IDENTIFIER) return "IDENTIFIER";
-            else if (type == NUMBER) return "NUMBER";
-            else if (type == FLOAT_NUMBER) return "FLOAT_NUMBER";
-            else if (type == STRING_LITERAL) return "STRING_LITERAL";
-            else if (type == CHAR_LITERAL) return "CHAR_LITERAL";
-            else if (type == OPERATOR) return "OPERATOR";
-            else return "ERROR";
-    }
-};
+#include "ast_cache.hpp"
+#include "ast_dump.hpp"
+#include "../Lab2/headers/lexer.hpp"
+#include "../Lab2/headers/mapped_file.hpp"
+#include "../Lab2/headers/token_file.hpp"
+#include "../Lab2/headers/token_source.hpp"
 
 // struct ASTNode {
 //     std::string type;
@@ -65,113 +52,483 @@ struct Token {
 //     }
 // };
 
-// Функция для чтения токенов из файла
-std::vector<Token> readTokensFromFile(const std::string& filename) {
-    std::vector<Token> tokens;
-    std::ifstream file(filename);
-    std::string line;
+// Поле [p, разделитель) строки, заканчивающейся в end; p переходит за разделитель.
+// Повторяет std::getline: если разделителя нет, поле - весь остаток.
+inline std::string_view takeField(const char*& p, const char* end, char delimiter) {
+    const char* stop = static_cast<const char*>(std::memchr(p, delimiter, end - p));
+    if (!stop) {
+        stop = end;
+    }
+    std::string_view field(p, stop - p);
+    p = stop == end ? end : stop + 1;
+    return field;
+}
 
-    if (!file.is_open()) {
-        std::cerr << "Ошибка открытия файла: " << filename << std::endl;
-        return tokens;
+// Тип токена по имени: выбор по первой букве и одно сравнение
+TokenType tokenTypeFromName(std::string_view name) {
+    switch (name.empty() ? '\0' : name[0]) {
+        case 'K': return name == "KEYWORD" ? KEYWORD : ERROR;
+        case 'I': return name == "IDENTIFIER" ? IDENTIFIER : ERROR;
+        case 'N': return name == "NUMBER" ? NUMBER : ERROR;
+        case 'F': return name == "FLOAT_NUMBER" ? FLOAT_NUMBER : ERROR;
+        case 'S': return name == "STRING_LITERAL" ? STRING_LITERAL : ERROR;
+        case 'C': return name == "CHAR_LITERAL" ? CHAR_LITERAL : ERROR;
+        case 'O': return name == "OPERATOR" ? OPERATOR : ERROR;
+        default: return ERROR;
+    }
+}
+
+// Номер строки с правилами std::stoi: пробельные символы в начале, знак,
+// цифры до первого постороннего символа
+std::from_chars_result parseLineNumber(std::string_view text, int& value) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end && std::isspace(static_cast<unsigned char>(*p))) {
+        p++;
     }
+    if (p + 1 < end && *p == '+' && std::isdigit(static_cast<unsigned char>(p[1]))) {
+        p++;
+    }
+    return std::from_chars(p, end, value);
+}
 
-    while (std::getline(file, line)) {
-        if (line.empty()) {
+// Функция для чтения токенов из текстового файла.
+// Лексемы токенов ссылаются на отображённый file без копирования.
+// Строка "Token: TYPE Lexem: @lexeme@ Line: N Id: M" разбирается
+// указателями по разделителям, как прежняя цепочка getline.
+// false - позицию токена нельзя разместить в таблице строк.
+bool readTokensFromFile(const MappedFile& file, std::vector<Token>& tokens) {
+    Interner& symbols = Interner::global();
+    LineTable& lines = LineTable::global();
+    lines.clear();
+    tokens.reserve(file.size() / 48);
+
+    const char* p = file.data();
+    const char* fileEnd = p + file.size();
+    while (p < fileEnd) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', fileEnd - p));
+        const char* next = lineEnd ? lineEnd + 1 : fileEnd;
+        if (!lineEnd) {
+            lineEnd = fileEnd;
+        }
+        if (lineEnd > p && lineEnd[-1] == '\r') {
+            lineEnd--;
+        }
+        const char* field = p;
+        p = next;
+        if (field == lineEnd) {
             continue; // Пропускаем пустые строки
         }
 
-        std::istringstream iss(line);
-        std::string tokenTypeStr, lexeme, lineStr, idStr;
-
-        std::getline(iss, tokenTypeStr, ' '); 
-        std::getline(iss, tokenTypeStr, ' '); 
-        std::getline(iss, lexeme, '@'); 
-        std::getline(iss, lexeme, '@'); 
+        takeField(field, lineEnd, ' ');
+        std::string_view tokenTypeStr = takeField(field, lineEnd, ' ');
+        takeField(field, lineEnd, '@');
+        std::string_view lexeme = takeField(field, lineEnd, '@');
+        takeField(field, lineEnd, ' ');
+        takeField(field, lineEnd, ' ');
+        std::string_view lineStr = takeField(field, lineEnd, ' ');
 
-        std::getline(iss, lineStr, ' ');
-        std::getline(iss, lineStr, ' ');
-        std::getline(iss, lineStr, ' ');
         // Извлечение номера строки
         int lineNum = 0;
-        try {
-            lineNum = std::stoi(lineStr);
-        } catch (const std::invalid_argument&) {
+        std::from_chars_result parsed = parseLineNumber(lineStr, lineNum);
+        if (parsed.ec == std::errc::invalid_argument) {
             std::cerr << "Ошибка преобразования номера строки: " << lineStr << std::endl;
             continue; // Пропускаем токен при ошибке
-        } catch (const std::out_of_range&) {
+        }
+        if (parsed.ec == std::errc::result_out_of_range) {
             std::cerr << "Номер строки вне допустимого диапазона: " << lineStr << std::endl;
             continue; // Пропускаем токен при ошибке
         }
-        // Определяем тип токена
-        TokenType type;
-        if (tokenTypeStr == "KEYWORD") type = KEYWORD;
-        else if (tokenTypeStr == "IDENTIFIER") type = IDENTIFIER;
-        else if (tokenTypeStr == "NUMBER") type = NUMBER;
-        else if (tokenTypeStr == "FLOAT_NUMBER") type = FLOAT_NUMBER;
-        else if (tokenTypeStr == "STRING_LITERAL") type = STRING_LITERAL;
-        else if (tokenTypeStr == "CHAR_LITERAL") type = CHAR_LITERAL;
-        else if (tokenTypeStr == "OPERATOR") type = OPERATOR;
-        else type = ERROR;
-
-        tokens.push_back({type, lexeme, lineNum});
+
+        TokenType type = tokenTypeFromName(tokenTypeStr);
+        TokenKind kind = type == KEYWORD || type == OPERATOR ? lookupLexicon(lexeme) : TK_NONE;
+        if (!lines.canSynthesize(lineNum, 0, lexeme.size())) {
+            std::cerr << "Повреждённый файл токенов: недопустимый номер строки " << lineStr << std::endl;
+            lines.clear();
+            return false;
+        }
+        SourceLoc loc = lines.synthesize(lineNum, 0, lexeme.size());
+        tokens.push_back({type, lexeme, loc, symbols.intern(lexeme), kind});
     }
 
-    file.close();
-    return tokens;
+    return true;
+}
+
+// Чтение двоичного файла токенов: записи берутся прямо из отображённой
+// памяти, каждая лексема таблицы строк добавляется в пул один раз
+bool readTokensFromBinary(const MappedFile& file, std::vector<Token>& tokens) {
+    TokenFileView view;
+    if (!view.open(file.view())) {
+        std::cerr << "Повреждённый файл токенов или неподдерживаемая версия" << std::endl;
+        return false;
+    }
+
+    Interner& symbols = Interner::global();
+    std::vector<SymbolId> ids(view.stringCount());
+    for (uint32_t i = 0; i < view.stringCount(); i++) {
+        ids[i] = symbols.intern(view.string(i));
+    }
+
+    // Исходника нет: таблица строк строится так, чтобы позиции токенов
+    // разворачивались в записанные в файле строку и столбец
+    LineTable& lines = LineTable::global();
+    lines.clear();
+    tokens.reserve(view.tokenCount());
+    for (uint32_t i = 0; i < view.tokenCount(); i++) {
+        const TokenRecord& record = view.record(i);
+        TokenType type = record.type <= ERROR ? static_cast<TokenType>(record.type) : ERROR;
+        TokenKind kind = record.kind < TOKEN_KIND_COUNT ? static_cast<TokenKind>(record.kind) : TK_NONE;
+        std::string_view lexeme = view.string(record.lexeme);
+        if (!lines.canSynthesize(static_cast<int>(record.line), static_cast<int>(record.column), lexeme.size())) {
+            std::cerr << "Повреждённый файл токенов или неподдерживаемая версия" << std::endl;
+            lines.clear();
+            tokens.clear();
+            return false;
+        }
+        SourceLoc loc = lines.synthesize(static_cast<int>(record.line), static_cast<int>(record.column),
+                                         lexeme.size());
+        tokens.push_back({type, lexeme, loc, ids[record.lexeme], kind});
+    }
+    return true;
+}
+
+// Файл токенов в любом из форматов: двоичный узнаётся по заголовку.
+// false - файл не открылся или повреждён, сообщение уже выведено
+bool readTokens(const std::string& filename, MappedFile& file, std::vector<Token>& tokens) {
+    tokens.clear();
+    if (!file.open(filename)) {
+        std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+        return false;
+    }
+    if (TokenFileView::isTokenFile(file.view())) {
+        return readTokensFromBinary(file, tokens);
+    }
+    if (!readTokensFromFile(file, tokens)) {
+        tokens.clear();
+        return false;
+    }
+    return true;
 }
 
 class ParseException : public std::exception {
     public:
-        ParseException(const std::string& message, int line)
-            : msg_(message), line_(line) {}
+        ParseException(const std::string& message, SourceLoc loc)
+            : msg_(message), loc_(loc) {}
     
         virtual const char* what() const noexcept override {
             return msg_.c_str();
         }
     
-        int getLine() const {
-            return line_;
+        SourceLoc getLoc() const {
+            return loc_;
         }
     
     private:
         std::string msg_;
-        int line_;
+        SourceLoc loc_;
     };
 
+// Сила связывания инфиксных операторов для парсера Пратта, по приоритетам
+// Java: чем больше, тем сильнее. Левоассоциативные операторы разбирают
+// правый операнд с right = left + 1, присваивания и ?: - с right < left.
+struct BindingPower {
+    unsigned char left;  // 0 - вид не является инфиксным оператором
+    unsigned char right;
+};
+
+constexpr unsigned char PREFIX_POWER = 25;
+constexpr unsigned char POSTFIX_POWER = 27;
+
+struct OperatorTable {
+    BindingPower infix[TOKEN_KIND_COUNT];
+};
+
+constexpr OperatorTable buildOperatorTable() {
+    OperatorTable table{};
+    const TokenKind assignments[] = {ASSIGN, PLUS_ASSIGN, MINUS_ASSIGN, STAR_ASSIGN, SLASH_ASSIGN, PERCENT_ASSIGN};
+    for (TokenKind kind : assignments) {
+        table.infix[kind] = {2, 1};
+    }
+    table.infix[QUESTION] = {4, 3};
+    table.infix[OR_OR] = {5, 6};
+    table.infix[AND_AND] = {7, 8};
+    table.infix[PIPE] = {9, 10};
+    table.infix[CARET] = {11, 12};
+    table.infix[AMP] = {13, 14};
+    table.infix[EQ_EQ] = table.infix[NOT_EQ] = {15, 16};
+    table.infix[LESS] = table.infix[GREATER] = table.infix[LESS_EQ] = table.infix[GREATER_EQ] = {17, 18};
+    table.infix[SHIFT_LEFT] = table.infix[SHIFT_RIGHT] = table.infix[UNSIGNED_SHIFT_RIGHT] = {19, 20};
+    table.infix[PLUS] = table.infix[MINUS] = {21, 22};
+    table.infix[STAR] = table.infix[SLASH] = table.infix[PERCENT] = {23, 24};
+    return table;
+}
+
+constexpr OperatorTable operatorTable = buildOperatorTable();
+
 class Parser {
     private:
-        std::vector<Token> tokens;
-        int current;
+        TokenSource& tokens;
+        AstArena& arena;
+        size_t depth = 0;     // текущая вложенность операторов и выражений
+        size_t maxDepth;
+        bool sharedSymbols = false; // разбор идёт одновременно с другими потоками
+
+        // Тело метода, отложенное для параллельного разбора: номера его
+        // '{' и парной '}' во входе
+        struct DeferredBody {
+            ASTNode* method;
+            size_t open;
+            size_t close;
+        };
+        // Номер парной '}' для каждой '{' или SIZE_MAX; задан только
+        // при параллельном разборе
+        const std::vector<size_t>* closingBrace = nullptr;
+        std::vector<DeferredBody> deferred;
+
+        // Вложенность разбора ограничена, чтобы слишком глубокий вход давал
+        // ошибку разбора, а не переполнение стека: рекурсивен только парсер,
+        // анализатор и генератор обходят дерево своими стеками. Уровень
+        // скобок или унарного оператора занимает две единицы предела.
+        // Длинные левые цепочки бинарных операторов строятся циклом и
+        // вложенностью не считаются.
+        class DepthGuard {
+        public:
+            DepthGuard(Parser& parser, SourceLoc loc) : parser(parser) {
+                if (parser.depth >= parser.maxDepth) {
+                    throw ParseException("Nesting is too deep", loc);
+                }
+                parser.depth++;
+            }
+            ~DepthGuard() {
+                parser.depth--;
+            }
+        private:
+            Parser& parser;
+        };
     
-        Token peek() {
-            return tokens[current];
+        // Ссылки указывают в буфер TokenSource; токен, который нужен после
+        // разбора вложенных конструкций, копируется (он не владеет строкой)
+        const Token& peek() {
+            return tokens.peek();
         }
     
-        Token consume() {
-            return tokens[current++];
+        const Token& consume() {
+            return tokens.consume();
         }
     
-        bool match(TokenType expected, std::string lexeme = "") {
-            if (current < tokens.size() && tokens[current].type == expected) {
-                if (lexeme.empty() || tokens[current].lexeme == lexeme) {
-                    consume();
-                    return true;
-                }
+        // Блокировка нужна, только когда тела разбираются в нескольких потоках
+        SymbolId intern(std::string_view text) {
+            Interner& symbols = Interner::global();
+            return sharedSymbols ? symbols.internShared(text) : symbols.intern(text);
+        }
+
+        // Ключевые слова и операторы различаются по виду, который
+        // присвоил лексер, без сравнения строк
+        bool match(TokenKind expected) {
+            if (!tokens.atEnd() && tokens.peek().kind == expected) {
+                consume();
+                return true;
+            }
+            return false;
+        }
+
+        // match() в циклах до закрывающей скобки. После конца входа
+        // TokenSource без конца выдаёт токен EOF, поэтому оборванный вход
+        // - ошибка разбора, а не бесконечный цикл
+        bool matchClosing(TokenKind closing) {
+            expectMore();
+            return match(closing);
+        }
+
+        void expectMore() {
+            if (tokens.atEnd()) {
+                throw ParseException("Unexpected end of input", tokens.peek().loc);
+            }
+        }
+
+        // Контекстные имена вроде System.out - обычные идентификаторы
+        bool matchIdentifier(std::string_view name) {
+            if (!tokens.atEnd() && tokens.peek().type == IDENTIFIER && tokens.peek().lexeme == name) {
+                consume();
+                return true;
             }
             return false;
         }
     
+        // Узлы дерева живут в арене и освобождаются вместе с ней
+        ASTNode* makeNode(ASTNode::NodeType type, SourceLoc loc) {
+            return arena.create<ASTNode>(type, loc, arena);
+        }
+    
     public:
-        Parser(std::vector<Token> t) : tokens(t), current(0) {}
+        // Сборка -O0 под стеком 1 МБ (MinGW по умолчанию) падает около
+        // 1900, предел берётся с запасом
+        static constexpr size_t DEFAULT_MAX_DEPTH = 1000;
+
+        Parser(TokenSource& source, AstArena& arena, size_t maxDepth = DEFAULT_MAX_DEPTH)
+            : tokens(source), arena(arena), maxDepth(maxDepth) {}
     
+        // Параллельный разбор: сигнатуры и поля разбираются здесь по порядку,
+        // тела методов пропускаются по заранее найденным парам скобок и
+        // потом разбираются на threads потоках, каждый в своей арене. Тела
+        // подвешиваются к своим методам, так что дерево совпадает с
+        // последовательным разбором. all - весь вход, из которого читает
+        // источник токенов этого парсера.
+        ASTNode* parseProgramParallel(const std::vector<Token>& all, unsigned threads) {
+            std::vector<size_t> closing = matchBraces(all);
+            closingBrace = &closing;
+            ASTNode* root = nullptr;
+            std::unique_ptr<ParseException> outlineError;
+            try {
+                root = parseProgram();
+            } catch (const ParseException& e) {
+                // Тела до места ошибки всё равно разбираются: ошибка в них
+                // встречается раньше и сообщается первой
+                outlineError.reset(new ParseException(e));
+            }
+            closingBrace = nullptr;
+
+            std::vector<ASTNode*> bodies(deferred.size(), nullptr);
+            std::vector<std::unique_ptr<ParseException>> errors(deferred.size());
+            size_t workerCount = std::max<size_t>(1, std::min<size_t>(threads, deferred.size()));
+            std::vector<AstArena*> arenas;
+            for (size_t i = 0; i < workerCount; i++) {
+                arenas.push_back(&arena.spawn());
+            }
+            std::atomic<size_t> nextBody(0);
+            auto work = [&](AstArena& local) {
+                for (size_t i = nextBody++; i < deferred.size(); i = nextBody++) {
+                    try {
+                        bodies[i] = parseDeferredBody(all, deferred[i], local, workerCount > 1);
+                    } catch (const ParseException& e) {
+                        errors[i].reset(new ParseException(e));
+                    }
+                }
+            };
+            std::vector<std::thread> workers;
+            for (size_t i = 1; i < workerCount; i++) {
+                workers.emplace_back(work, std::ref(*arenas[i]));
+            }
+            work(*arenas[0]);
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+
+            for (size_t i = 0; i < deferred.size(); i++) {
+                if (errors[i]) {
+                    throw *errors[i];
+                }
+                deferred[i].method->addChild(bodies[i]);
+            }
+            deferred.clear();
+            if (outlineError) {
+                throw *outlineError;
+            }
+            return root;
+        }
+
+        // Ленивый разбор: тела методов пропускаются, как при параллельном
+        // разборе, а разбираются только тела методов, достижимых из main и
+        // из инициализаторов полей. Метод достижим, если его имя встречается
+        // в вызове уже разобранного кода (перегрузки и одноимённые методы
+        // других классов считаются достижимыми все сразу). Недостижимые
+        // методы удаляются из классов и не доходят до анализатора и
+        // генератора; ошибки в их телах не сообщаются.
+        ASTNode* parseProgramLazy(const std::vector<Token>& all) {
+            std::vector<size_t> closing = matchBraces(all);
+            closingBrace = &closing;
+            ASTNode* root = parseProgram();
+            closingBrace = nullptr;
+
+            std::unordered_map<SymbolId, std::vector<size_t>> bodiesByName;
+            for (size_t i = 0; i < deferred.size(); i++) {
+                bodiesByName[deferred[i].method->getName()].push_back(i);
+            }
+            std::vector<SymbolId> pending = {intern("main")};
+            collectCalls(root, pending);
+            std::vector<bool> used(deferred.size(), false);
+            while (!pending.empty()) {
+                auto found = bodiesByName.find(pending.back());
+                pending.pop_back();
+                if (found == bodiesByName.end()) {
+                    continue;
+                }
+                for (size_t i : found->second) {
+                    if (used[i]) {
+                        continue;
+                    }
+                    used[i] = true;
+                    ASTNode* body = parseDeferredBody(all, deferred[i], arena, false);
+                    deferred[i].method->addChild(body);
+                    collectCalls(body, pending);
+                }
+            }
+
+            std::unordered_set<const ASTNode*> unused;
+            for (size_t i = 0; i < deferred.size(); i++) {
+                if (!used[i]) {
+                    unused.insert(deferred[i].method);
+                }
+            }
+            deferred.clear();
+            for (size_t c = 0; c < root->getChildCount(); c++) {
+                ASTNode* classBlock = root->getChild(c)->getChild(0);
+                if (classBlock) {
+                    classBlock->removeChildrenIf([&](const ASTNode* member) { return unused.count(member) > 0; });
+                }
+            }
+            return root;
+        }
+
+        // Имена вызываемых в поддереве методов: прямые вызовы и вызовы через точку
+        static void collectCalls(const ASTNode* tree, std::vector<SymbolId>& names) {
+            std::vector<const ASTNode*> stack = {tree};
+            while (!stack.empty()) {
+                const ASTNode* node = stack.back();
+                stack.pop_back();
+                if (node->getType() == ASTNode::METHOD_CALL) {
+                    names.push_back(node->getName());
+                } else if (node->getType() == ASTNode::FIELD_ACCESS) {
+                    names.push_back(node->getField());
+                }
+                for (size_t i = 0; i < node->getChildCount(); i++) {
+                    stack.push_back(node->getChild(i));
+                }
+            }
+        }
+
+        // Разбор отложенного тела метода отдельным парсером в арену target;
+        // shared - параллельно работают другие такие парсеры
+        ASTNode* parseDeferredBody(const std::vector<Token>& all, const DeferredBody& body, AstArena& target, bool shared) {
+            SpanTokenSource source(all.data() + body.open, all.data() + body.close + 1);
+            Parser parser(source, target, maxDepth);
+            parser.sharedSymbols = shared;
+            parser.match(LBRACE);
+            return parser.parseMethodBody();
+        }
+
+        // Для каждой '{' номер парной '}', для остальных токенов SIZE_MAX
+        static std::vector<size_t> matchBraces(const std::vector<Token>& all) {
+            std::vector<size_t> closing(all.size(), SIZE_MAX);
+            std::vector<size_t> open;
+            for (size_t i = 0; i < all.size(); i++) {
+                if (all[i].kind == LBRACE) {
+                    open.push_back(i);
+                } else if (all[i].kind == RBRACE && !open.empty()) {
+                    closing[open.back()] = i;
+                    open.pop_back();
+                }
+            }
+            return closing;
+        }
+
         ASTNode* parseProgram() {
-            ASTNode* root = new ASTNode(ASTNode::PROGRAM, tokens[current].line);
+            ASTNode* root = makeNode(ASTNode::PROGRAM, tokens.peek().loc);
             // ASTNode* root = new ASTNode("Program");
-            while(tokens[current].lexeme != "public"){
-                current++;
+            while(!tokens.atEnd() && tokens.peek().kind != KW_PUBLIC){
+                tokens.consume();
             }
-            while (current < tokens.size()) {
+            while (!tokens.atEnd()) {
                 root->addChild(parseClassDeclaration());
             }
             return root;
@@ -189,19 +546,19 @@ class Parser {
         // }
 
         ASTNode* parseClassDeclaration() {
-            match(KEYWORD, "public");
-            match(KEYWORD, "class");
+            match(KW_PUBLIC);
+            match(KW_CLASS);
             Token className = consume(); // IDENTIFIER
-            match(OPERATOR, "{");
+            match(LBRACE);
     
-            ASTNode* classNode = new ASTNode(ASTNode::CLASS_DECL, className.line);
-            classNode->setAttribute("name", className.lexeme);
-            ASTNode* block = new ASTNode(ASTNode::BLOCK, tokens[current - 1].line);
+            ASTNode* classNode = makeNode(ASTNode::CLASS_DECL, className.loc);
+            classNode->setName(className.id);
+            ASTNode* block = makeNode(ASTNode::BLOCK, tokens.previous().loc);
 
             // ASTNode* classNode = new ASTNode("ClassDeclaration", className.lexeme);
             // classNode->addChild(new ASTNode("BlockStart", "{")); // Добавляем открывающую скобку
 
-            while (!match(OPERATOR, "}")) {
+            while (!matchClosing(RBRACE)) {
                 block->addChild(parseClassMember());
                 // classNode->addChild(parseClassMember());
             }
@@ -211,8 +568,8 @@ class Parser {
         }
     
         ASTNode* parseClassMember() {
-            if (match(KEYWORD, "public")) {
-                if (match(KEYWORD, "static")) {
+            if (match(KW_PUBLIC)) {
+                if (match(KW_STATIC)) {
                     return parseMethodDeclaration();
                 }
             }
@@ -220,13 +577,13 @@ class Parser {
         }
     
         ASTNode* parseParameterList() {
-            ASTNode* paramList = new ASTNode(ASTNode::PARAMETER_LIST, tokens[current].line);
-            paramList->setAttribute("type", "parameters");
+            ASTNode* paramList = makeNode(ASTNode::PARAMETER_LIST, tokens.peek().loc);
+            paramList->setTypeName(intern("parameters"));
             // ASTNode* paramList = new ASTNode("ParameterList");
             // paramList->addChild(new ASTNode("ParenthesisStart", "(")); // Добавляем открывающую скобку
             
             do {
-                if(peek().lexeme == "ArrayList"){
+                if(peek().kind == KW_ARRAYLIST){
                     ASTNode* paramNode = parseArrayList();
                     // ASTNode* paramNode = new ASTNode(ASTNode::PARAMETER, array->getLine());
                     // paramNode->setAttribute("type", type);
@@ -235,20 +592,20 @@ class Parser {
                     // paramNode->addChild(new ASTNode("Type", "ArrayList<" + array->children[0]->value + ">"));
                     paramList->addChild(paramNode);
                 }
-                else if(peek().lexeme == "HashMap"){
+                else if(peek().kind == KW_HASHMAP){
                     ASTNode* map = parseHashMap();
                     paramList->addChild(map);
                 } else {
-                    std::string type = consume().lexeme;
+                    std::string type(consume().lexeme);
                     Token paramName = consume();
-                    ASTNode* paramNode = new ASTNode(ASTNode::PARAMETER, paramName.line);
-                    paramNode->setAttribute("type", type);
-                    paramNode->setAttribute("name", paramName.lexeme);
+                    ASTNode* paramNode = makeNode(ASTNode::PARAMETER, paramName.loc);
+                    paramNode->setTypeName(intern(type));
+                    paramNode->setName(paramName.id);
                     // ASTNode* paramNode = new ASTNode("Parameter", paramName.lexeme);
                     // paramNode->addChild(new ASTNode("Type", type));
                     paramList->addChild(paramNode);
                 }
-            } while (match(OPERATOR, ","));
+            } while (match(COMMA));
             // paramList->addChild(new ASTNode("ParenthesisEnd", ")")); // Добавляем открывающую скобку
 
             return paramList;
@@ -257,28 +614,43 @@ class Parser {
         ASTNode* parseMethodDeclaration() {
             Token returnType = consume();
             Token methodName = consume(); // IDENTIFIER
-            match(OPERATOR, "(");
+            match(LPAREN);
             
-            ASTNode* methodNode = new ASTNode(ASTNode::METHOD_DECL, methodName.line);
-            methodNode->setAttribute("returnType", returnType.lexeme);
-            methodNode->setAttribute("name", methodName.lexeme);
+            ASTNode* methodNode = makeNode(ASTNode::METHOD_DECL, methodName.loc);
+            methodNode->setTypeName(intern(returnType.lexeme));
+            methodNode->setName(methodName.id);
             // ASTNode* block = new ASTNode(ASTNode::BLOCK, tokens[current - 1].line);
             // ASTNode* methodNode = new ASTNode("MethodDeclaration", methodName.lexeme);
-            if (!match(OPERATOR, ")")) {
+            if (!match(RPAREN)) {
                 methodNode->addChild(parseParameterList());
-                match(OPERATOR, ")");
+                match(RPAREN);
             }
-            match(OPERATOR, "{");
-            ASTNode* block = new ASTNode(ASTNode::BLOCK, tokens[current - 1].line);
+            // При параллельном разборе тело пропускается до парной скобки
+            // и разбирается потом отдельно
+            size_t open = tokens.position();
+            if (closingBrace && peek().kind == LBRACE && (*closingBrace)[open] != SIZE_MAX) {
+                size_t close = (*closingBrace)[open];
+                deferred.push_back({methodNode, open, close});
+                while (tokens.position() <= close) {
+                    consume();
+                }
+                return methodNode;
+            }
+            match(LBRACE);
             // methodNode->addChild(new ASTNode("BlockStart", "{")); // Добавляем открывающую скобку
             // match(OPERATOR, "{");
-    
-            while (!match(OPERATOR, "}")) {
+            methodNode->addChild(parseMethodBody());
+            return methodNode;
+        }
+
+        // Операторы тела метода после '{' до парной '}'
+        ASTNode* parseMethodBody() {
+            ASTNode* block = makeNode(ASTNode::BLOCK, tokens.previous().loc);
+            while (!matchClosing(RBRACE)) {
                 block->addChild(parseStatement());
                 // methodNode->addChild(parseStatement());
             }
-            methodNode->addChild(block);
-            return methodNode;
+            return block;
         }
     
 
@@ -295,29 +667,29 @@ class Parser {
             // } else if(peek().lexeme == "HashMap"){
 
             // } else{
-                std::string type = consume().lexeme;
+                std::string type(consume().lexeme);
                 Token varName = consume(); // IDENTIFIER
 
-                ASTNode* varNode = new ASTNode(ASTNode::VARIABLE_DECL, varName.line);
-                varNode->setAttribute("type", type);
-                varNode->setAttribute("name", varName.lexeme);
+                ASTNode* varNode = makeNode(ASTNode::VARIABLE_DECL, varName.loc);
+                varNode->setTypeName(intern(type));
+                varNode->setName(varName.id);
                 // ASTNode* varNode = new ASTNode("VariableDeclaration", varName.lexeme);
                 // varNode->addChild(new ASTNode("Type", type));
-                if (match(OPERATOR, "=")) {
-                    if(peek().lexeme == "{"){
+                if (match(ASSIGN)) {
+                    if(peek().kind == LBRACE){
                         varNode->addChild(parseArrayInitializer());
                     } else{
                         // Обработать вызов функции
-                        if(tokens[current + 1].lexeme == "." && tokens[current + 3].lexeme == "(" && (tokens[current + 4].lexeme == ")" || tokens[current + 5].lexeme == ")")){
+                        if(tokens.peek(1).kind == DOT && tokens.peek(3).kind == LPAREN && (tokens.peek(4).kind == RPAREN || tokens.peek(5).kind == RPAREN)){
                             varNode->addChild(parseMethodCall());
-                        } else if(tokens[current + 1].lexeme == "("){
+                        } else if(tokens.peek(1).kind == LPAREN){
                             varNode->addChild(parseFunctionCall());
                         } else{
                             varNode->addChild(parseExpression());
                         }
                     }
                 }
-                match(OPERATOR, ";");
+                match(SEMICOLON);
                 // varNode->addChild(new ASTNode("Semicolon", ";"));
             // }
             return varNode;
@@ -325,67 +697,67 @@ class Parser {
         
         ASTNode* parseVariableAssigment() {
                 Token varName = consume(); 
-                ASTNode* varNode = new ASTNode(ASTNode::ASSIGNMENT, varName.line);
+                ASTNode* varNode = makeNode(ASTNode::ASSIGNMENT, varName.loc);
 
                 if(varName.lexeme.find("[") != std::string::npos){
-                    ASTNode* node = new ASTNode(ASTNode::ARRAY_ACCESS, varName.line);
-                    ASTNode* var = new ASTNode(ASTNode::VARIABLE, varName.line);
-                    var->setAttribute("name", varName.lexeme.substr(0, varName.lexeme.find("[")));
+                    ASTNode* node = makeNode(ASTNode::ARRAY_ACCESS, varName.loc);
+                    ASTNode* var = makeNode(ASTNode::VARIABLE, varName.loc);
+                    var->setName(intern(varName.lexeme.substr(0, varName.lexeme.find("["))));
                     size_t start = varName.lexeme.find("[") + 1;
                     size_t end = varName.lexeme.find("]");
                     size_t length = end - start;
-                    std::string index = varName.lexeme.substr(start, length);
+                    std::string index(varName.lexeme.substr(start, length));
                     node->addChild(var);
                     try {
                         int intIndex = std::stoi(index); 
-                        ASTNode* i = new ASTNode(ASTNode::LITERAL, varName.line);
-                        i->setAttribute("literalType", "int");
-                        i->setAttribute("name", index);
+                        ASTNode* i = makeNode(ASTNode::LITERAL, varName.loc);
+                        i->setLiteral(ASTNode::INT_LITERAL, "");
+                        i->setName(intern(index));
                         node->addChild(i);
                     } catch (const std::invalid_argument& e) {
-                        ASTNode* i = new ASTNode(ASTNode::VARIABLE, varName.line);
-                        i->setAttribute("name", index);
+                        ASTNode* i = makeNode(ASTNode::VARIABLE, varName.loc);
+                        i->setName(intern(index));
                         node->addChild(i);
                     } 
                     varNode->addChild(node);
                 } else{
-                    ASTNode* left = new ASTNode(ASTNode::VARIABLE, varName.line);
-                    left->setAttribute("name", varName.lexeme);
+                    ASTNode* left = makeNode(ASTNode::VARIABLE, varName.loc);
+                    left->setName(varName.id);
                     varNode->addChild(left);
                 }
-                if (match(OPERATOR, "=")) {
-                    if(peek().lexeme == "{"){
+                if (match(ASSIGN)) {
+                    if(peek().kind == LBRACE){
                         varNode->addChild(parseArrayInitializer());
                     } else{
                         varNode->addChild(parseExpression());
                     }
                 }
-                match(OPERATOR, ";");
+                match(SEMICOLON);
             return varNode;
         }
 
         ASTNode* parseArrayInitializer() {
-            ASTNode* arrayNode = new ASTNode(ASTNode::ARRAY_INIT, consume().line);
-            match(OPERATOR, "{");
+            ASTNode* arrayNode = makeNode(ASTNode::ARRAY_INIT, consume().loc);
+            match(LBRACE);
             
-            while (!match(OPERATOR, "}")) {
+            while (!matchClosing(RBRACE)) {
                 arrayNode->addChild(parseExpression());
-                if (peek().lexeme == ",") consume();
+                if (peek().kind == COMMA) consume();
             }
             
             return arrayNode;
         }
 
         ASTNode* parseArrayList() {
-            match(KEYWORD, "ArrayList");
-            match(OPERATOR, "<");
+            match(KW_ARRAYLIST);
+            match(LESS);
             Token type = consume();
-            match(OPERATOR, ">");
+            match(GREATER);
             Token varName = consume();
             
-            ASTNode* arrayListNode = new ASTNode(ASTNode::PARAMETER, varName.line);
-            arrayListNode->setAttribute("type", "ArrayList<" + type.lexeme + ">");
-            arrayListNode->setAttribute("name", varName.lexeme);
+            ASTNode* arrayListNode = makeNode(ASTNode::PARAMETER, varName.loc);
+            arrayListNode->setTypeName(intern("ArrayList<" + std::string(type.lexeme) + ">"));
+            arrayListNode->setName(varName.id);
             // ASTNode* arrayListNode = new ASTNode("ArrayList", varName.lexeme);
             // arrayListNode->addChild(new ASTNode("Type", type.lexeme));
     
@@ -393,16 +765,16 @@ class Parser {
         }
 
         ASTNode* parseHashMap(){
-            match(KEYWORD, "HashMap");
-            match(OPERATOR, "<");
+            match(KW_HASHMAP);
+            match(LESS);
             Token type1 = consume();
-            match(OPERATOR, ",");
+            match(COMMA);
             Token type2 = consume();
-            match(OPERATOR, ">");
+            match(GREATER);
             Token varName = consume();
-            ASTNode* hashMapNode = new ASTNode(ASTNode::PARAMETER, varName.line);
-            hashMapNode->setAttribute("type", "HashMap<" + type1.lexeme + ", " + type2.lexeme + ">");
-            hashMapNode->setAttribute("name", varName.lexeme);
+            ASTNode* hashMapNode = makeNode(ASTNode::PARAMETER, varName.loc);
+            hashMapNode->setTypeName(intern("HashMap<" + std::string(type1.lexeme) + ", " + std::string(type2.lexeme) + ">"));
+            hashMapNode->setName(varName.id);
             // ASTNode* hashMapNode = new ASTNode("HashMap", varName.lexeme);
             // hashMapNode->addChild(new ASTNode("KeyType", type1.lexeme));
             // hashMapNode->addChild(new ASTNode("ValueType", type2.lexeme));
@@ -412,56 +784,56 @@ class Parser {
     
         ASTNode* parseVariableArrayList(){
             // ASTNode* array = parseArrayList();
-            match(KEYWORD, "ArrayList");
-            match(OPERATOR, "<");
+            match(KW_ARRAYLIST);
+            match(LESS);
             Token type = consume();
-            match(OPERATOR, ">");
+            match(GREATER);
             Token varName = consume();
             
-            ASTNode* arrayListNode = new ASTNode(ASTNode::VARIABLE_DECL, varName.line);
-            arrayListNode->setAttribute("type", "ArrayList<" + type.lexeme + ">");
-            arrayListNode->setAttribute("name", varName.lexeme);
+            ASTNode* arrayListNode = makeNode(ASTNode::VARIABLE_DECL, varName.loc);
+            arrayListNode->setTypeName(intern("ArrayList<" + std::string(type.lexeme) + ">"));
+            arrayListNode->setName(varName.id);
            
             // ASTNode* varNode = new ASTNode("VariableDeclaration", array->value);
             // varNode->addChild(new ASTNode("Type", "ArrayList<" + array->children[0]->value + ">"));
-            if (match(OPERATOR, "=")) {
-                match(KEYWORD, "new");
-                match(KEYWORD, "ArrayList");
-                match(OPERATOR, "<");
-                match(OPERATOR, ">");
-                match(OPERATOR, "(");
-                match(OPERATOR, ")");
+            if (match(ASSIGN)) {
+                match(KW_NEW);
+                match(KW_ARRAYLIST);
+                match(LESS);
+                match(GREATER);
+                match(LPAREN);
+                match(RPAREN);
                 // varNode->addChild(parseExpression());
             }
-            match(OPERATOR, ";");
+            match(SEMICOLON);
             // varNode->addChild(new ASTNode("Semicolon", ";"));
             return arrayListNode;
         }
 
         ASTNode* parseVariableHashMap(){
             // ASTNode* array = parseHashMap();
-            match(KEYWORD, "HashMap");
-            match(OPERATOR, "<");
+            match(KW_HASHMAP);
+            match(LESS);
             Token type1 = consume();
-            match(OPERATOR, ",");
+            match(COMMA);
             Token type2 = consume();
-            match(OPERATOR, ">");
+            match(GREATER);
             Token varName = consume();
-            ASTNode* hashMapNode = new ASTNode(ASTNode::VARIABLE_DECL, varName.line);
-            hashMapNode->setAttribute("type", "HashMap<" + type1.lexeme + "," + type2.lexeme + ">");
-            hashMapNode->setAttribute("name", varName.lexeme);
+            ASTNode* hashMapNode = makeNode(ASTNode::VARIABLE_DECL, varName.loc);
+            hashMapNode->setTypeName(intern("HashMap<" + std::string(type1.lexeme) + "," + std::string(type2.lexeme) + ">"));
+            hashMapNode->setName(varName.id);
             // ASTNode* varNode = new ASTNode("VariableDeclaration", array->value);
             // varNode->addChild(new ASTNode("Type", "HashMap<" + array->children[0]->value + ", " + array->children[1]->value + ">"));
-            if (match(OPERATOR, "=")) {
-                match(KEYWORD, "new");
-                match(KEYWORD, "HashMap");
-                match(OPERATOR, "<");
-                match(OPERATOR, ">");
-                match(OPERATOR, "(");
-                match(OPERATOR, ")");
+            if (match(ASSIGN)) {
+                match(KW_NEW);
+                match(KW_HASHMAP);
+                match(LESS);
+                match(GREATER);
+                match(LPAREN);
+                match(RPAREN);
                 // varNode->addChild(parseExpression());
             }
-            match(OPERATOR, ";");
+            match(SEMICOLON);
             // varNode->addChild(new ASTNode("Semicolon", ";"));
             return hashMapNode;
         }
@@ -483,30 +855,30 @@ class Parser {
         // }
 
         ASTNode* parseIfStatement() {
-            match(KEYWORD, "if");
-            match(OPERATOR, "(");
-            ASTNode* ifNode = new ASTNode(ASTNode::IF_STMT, tokens[current - 1].line);
+            match(KW_IF);
+            match(LPAREN);
+            ASTNode* ifNode = makeNode(ASTNode::IF_STMT, tokens.previous().loc);
             // ASTNode* condition = new ASTNode("Condition", "");
-            ifNode->addChild(parseCondition());
-            match(OPERATOR, ")");
+            ifNode->addChild(parseExpression());
+            match(RPAREN);
             
-            match(OPERATOR, "{");
-            ASTNode* thenBlock = new ASTNode(ASTNode::BLOCK, tokens[current - 1].line);
+            match(LBRACE);
+            ASTNode* thenBlock = makeNode(ASTNode::BLOCK, tokens.previous().loc);
             // ASTNode* ifBlock = new ASTNode("IfStatement");
             // ifBlock->addChild(new ASTNode("ParenthesisStart", "(")); // Добавляем открывающую скобку
             // ifBlock->addChild(condition);
             // ifBlock->addChild(new ASTNode("ParenthesisEnd", ")")); // Добавляем открывающую скобку
             // ifBlock->addChild(new ASTNode("BlockStart", "{"));
-            while (!match(OPERATOR, "}")) {
+            while (!matchClosing(RBRACE)) {
                 thenBlock->addChild(parseStatement());
             }
             ifNode->addChild(thenBlock);
             // ifBlock->addChild(new ASTNode("BlockEnd", "}"));
-            if (match(KEYWORD, "else")) {
-                match(OPERATOR, "{");
-                ASTNode* elseBlock = new ASTNode(ASTNode::BLOCK, tokens[current - 1].line);
+            if (match(KW_ELSE)) {
+                match(LBRACE);
+                ASTNode* elseBlock = makeNode(ASTNode::BLOCK, tokens.previous().loc);
                 // elseBlock->addChild(new ASTNode("BlockStart", "{"));
-                while (!match(OPERATOR, "}")) {
+                while (!matchClosing(RBRACE)) {
                     elseBlock->addChild(parseStatement());
                 }
                 // elseBlock->addChild(new ASTNode("BlockEnd", "}"));
@@ -517,17 +889,17 @@ class Parser {
         }
     
         ASTNode* parseWhileLoop() {
-            match(KEYWORD, "while");
-            match(OPERATOR, "(");
-            ASTNode* whileNode = new ASTNode(ASTNode::WHILE_STMT, tokens[current - 1].line);
+            match(KW_WHILE);
+            match(LPAREN);
+            ASTNode* whileNode = makeNode(ASTNode::WHILE_STMT, tokens.previous().loc);
             // ASTNode* condition = new ASTNode("Condition", "");
-            whileNode->addChild(parseCondition());
+            whileNode->addChild(parseExpression());
             // ASTNode* condition = new ASTNode("Condition", "");
             // condition->addChild(parseCondition());
-            match(OPERATOR, ")");
+            match(RPAREN);
             
-            match(OPERATOR, "{");
-            ASTNode* block = new ASTNode(ASTNode::BLOCK, tokens[current - 1].line);
+            match(LBRACE);
+            ASTNode* block = makeNode(ASTNode::BLOCK, tokens.previous().loc);
             
             // ASTNode* whileNode = new ASTNode("WhileLoop");
             // whileNode->addChild(new ASTNode("ParenthesisStart", "(")); // Добавляем открывающую скобку
@@ -535,7 +907,7 @@ class Parser {
             // whileNode->addChild(new ASTNode("ParenthesisEnd", ")")); // Добавляем открывающую скобку
 
             // whileNode->addChild(new ASTNode("BlockStart", "{"));
-            while (!match(OPERATOR, "}")) {
+            while (!matchClosing(RBRACE)) {
                 block->addChild(parseStatement());
             }
             whileNode->addChild(block);
@@ -544,37 +916,37 @@ class Parser {
         }
     
         ASTNode* parseDoWhileLoop() {
-            match(KEYWORD, "do");
-            match(OPERATOR, "{");
+            match(KW_DO);
+            match(LBRACE);
     
-            ASTNode* doWhileNode = new ASTNode(ASTNode::DO_WHILE_STMT, tokens[current - 1].line);
+            ASTNode* doWhileNode = makeNode(ASTNode::DO_WHILE_STMT, tokens.previous().loc);
             // ASTNode* doWhileNode = new ASTNode("DoWhileLoop");
             // doWhileNode->addChild(new ASTNode("BlockStart", "{"));
-            ASTNode* block = new ASTNode(ASTNode::BLOCK, tokens[current - 1].line);
+            ASTNode* block = makeNode(ASTNode::BLOCK, tokens.previous().loc);
 
-            while (!match(OPERATOR, "}")) {
+            while (!matchClosing(RBRACE)) {
                 block->addChild(parseStatement());
             }
             doWhileNode->addChild(block);
             
-            match(KEYWORD, "while");
-            match(OPERATOR, "(");
+            match(KW_WHILE);
+            match(LPAREN);
             // doWhileNode->addChild(new ASTNode("ParenthesisStart", "(")); // Добавляем открывающую скобку
-            doWhileNode->addChild(parseCondition());
+            doWhileNode->addChild(parseExpression());
             // ASTNode* condition = new ASTNode("Condition", "");
             // condition->addChild(parseCondition());
             // doWhileNode->addChild(condition);
-            match(OPERATOR, ")");
+            match(RPAREN);
             // doWhileNode->addChild(new ASTNode("ParenthesisEnd", ")")); // Добавляем открывающую скобку
 
-            match(OPERATOR, ";");
+            match(SEMICOLON);
     
             return doWhileNode;
         }
 
         ASTNode* parseForLoop() {
-            match(KEYWORD, "for");
-            match(OPERATOR, "(");
+            match(KW_FOR);
+            match(LPAREN);
             
             ASTNode* init = nullptr;
             // if(tokens[current + 2].lexeme == ":"){
@@ -616,20 +988,20 @@ class Parser {
 
                 // return forNode;
             // } else{
-            ASTNode* forNode = new ASTNode(ASTNode::FOR_STMT, tokens[current-1].line);
-                if (!match(OPERATOR, ";")) {
+            ASTNode* forNode = makeNode(ASTNode::FOR_STMT, tokens.previous().loc);
+                if (!match(SEMICOLON)) {
                     init = parseVariableDeclaration();
                     forNode->addChild(init);
                 }
 
                 // ASTNode* condition = new ASTNode("Condition", "");
-                forNode->addChild(parseCondition());
-                match(OPERATOR, ";");
+                forNode->addChild(parseExpression());
+                match(SEMICOLON);
 
                 // ASTNode* iteration = new ASTNode("IterationChange", "");
                 forNode->addChild(parseExpression());
-                match(OPERATOR, ")");
-                match(OPERATOR, "{");
+                match(RPAREN);
+                match(LBRACE);
 
                 // ASTNode* forNode = new ASTNode("ForLoop");
                 // forNode->addChild(new ASTNode("ParenthesisStart", "(")); // Добавляем открывающую скобку
@@ -639,8 +1011,8 @@ class Parser {
                 // forNode->addChild(iteration);
                 // forNode->addChild(new ASTNode("ParenthesisEnd", ")")); // Добавляем открывающую скобку
                 // forNode->addChild(new ASTNode("BlockStart", "{"));
-                ASTNode* block = new ASTNode(ASTNode::BLOCK, tokens[current - 1].line);
-                while (!match(OPERATOR, "}")) {
+                ASTNode* block = makeNode(ASTNode::BLOCK, tokens.previous().loc);
+                while (!matchClosing(RBRACE)) {
                     block->addChild(parseStatement());
                 }
                 forNode->addChild(block);
@@ -650,33 +1022,36 @@ class Parser {
         }
     
         ASTNode* parseSwitchCaseStatement() {
-            ASTNode* switchNode = new ASTNode(ASTNode::SWITCH_STMT, consume().line);
+            ASTNode* switchNode = makeNode(ASTNode::SWITCH_STMT, consume().loc);
             
-            match(OPERATOR, "(");
+            match(LPAREN);
             switchNode->addChild(parseExpression());
-            match(OPERATOR, ")");
-            match(OPERATOR, "{");
+            match(RPAREN);
+            match(LBRACE);
             
-            while (!match(OPERATOR, "}")) {
-                if (match(KEYWORD, "case")) {
-                    ASTNode* caseNode = new ASTNode(ASTNode::CASE, tokens[current - 1].line);
+            while (!matchClosing(RBRACE)) {
+                if (match(KW_CASE)) {
+                    ASTNode* caseNode = makeNode(ASTNode::CASE, tokens.previous().loc);
                     caseNode->addChild(parseExpression());
-                    match(OPERATOR, ":");
-                    while (!match(KEYWORD, "case") && !match(KEYWORD, "default") && !match(OPERATOR, "}")) {
+                    match(COLON);
+                    while (!matchClosing(KW_CASE) && !match(KW_DEFAULT) && !match(RBRACE)) {
                         caseNode->addChild(parseStatement());
                     }
-                    --current;
+                    tokens.unconsume();
                     switchNode->addChild(caseNode);
                 }
-                else if (match(KEYWORD, "default")) {
-                    ASTNode* defaultNode = new ASTNode(ASTNode::DEFAULT, tokens[current - 1].line);
-                    match(OPERATOR, ":");
-                    while (!match(KEYWORD, "case") && !match(KEYWORD, "default") && !match(OPERATOR, "}")) {
+                else if (match(KW_DEFAULT)) {
+                    ASTNode* defaultNode = makeNode(ASTNode::DEFAULT, tokens.previous().loc);
+                    match(COLON);
+                    while (!matchClosing(KW_CASE) && !match(KW_DEFAULT) && !match(RBRACE)) {
                         defaultNode->addChild(parseStatement());
                     }
-                    --current;
+                    tokens.unconsume();
                     switchNode->addChild(defaultNode);
                 }
+                else {
+                    throw ParseException("Expected case or default", peek().loc);
+                }
             }
             
             return switchNode;
@@ -720,58 +1095,59 @@ class Parser {
         // }
 
         ASTNode* parseFunctionCall(){
-            ASTNode* statement = new ASTNode(ASTNode::METHOD_CALL, tokens[current].line);
+            ASTNode* statement = makeNode(ASTNode::METHOD_CALL, tokens.peek().loc);
             Token token = consume();
-            statement->setAttribute("name", token.lexeme);
-            match(OPERATOR, "(");
+            statement->setName(token.id);
+            match(LPAREN);
             
-            while(!match(OPERATOR, ")")){
+            while(!matchClosing(RPAREN)){
                 statement->addChild(parseExpression());
-                match(OPERATOR, ",");
+                match(COMMA);
             } 
-            match(OPERATOR, ";");
+            match(SEMICOLON);
             return statement;
         }
 
         ASTNode* parseMethodCall(){
             Token t = consume();
-            ASTNode* methodNode = new ASTNode(ASTNode::METHOD_CALL, t.line);
-            ASTNode* node = new ASTNode(ASTNode::FIELD_ACCESS, t.line);
-            ASTNode* object = new ASTNode(ASTNode::VARIABLE, t.line);
-            match(OPERATOR, ".");
-            object->setAttribute("name", t.lexeme);
+            ASTNode* methodNode = makeNode(ASTNode::METHOD_CALL, t.loc);
+            ASTNode* node = makeNode(ASTNode::FIELD_ACCESS, t.loc);
+            ASTNode* object = makeNode(ASTNode::VARIABLE, t.loc);
+            match(DOT);
+            object->setName(t.id);
             node->addChild(object);
-            node->setAttribute("field", consume().lexeme);
+            node->setField(consume().id);
             methodNode->addChild(node);
-            match(OPERATOR, "(");
-            while(!match(OPERATOR, ")")) {
+            match(LPAREN);
+            while(!matchClosing(RPAREN)) {
                 methodNode->addChild(parseExpression());
-                match(OPERATOR, ",");
+                match(COMMA);
             }
-            match(OPERATOR, ";");
+            match(SEMICOLON);
             return methodNode;
         }
 
 
 
         ASTNode* parseStatement() {
-            ASTNode* exprStatement = new ASTNode(ASTNode::EXPRESSION_STMT, tokens[current].line);
+            DepthGuard guard(*this, peek().loc);
+            ASTNode* exprStatement = makeNode(ASTNode::EXPRESSION_STMT, tokens.peek().loc);
             if (peek().type == KEYWORD) {
-                if (peek().lexeme == "if") return parseIfStatement();
-                else if (peek().lexeme == "while") return parseWhileLoop();
-                else if (peek().lexeme == "for") return parseForLoop();
-                else if (peek().lexeme == "do") return parseDoWhileLoop();
-                else if (peek().lexeme == "switch") return parseSwitchCaseStatement();
+                if (peek().kind == KW_IF) return parseIfStatement();
+                else if (peek().kind == KW_WHILE) return parseWhileLoop();
+                else if (peek().kind == KW_FOR) return parseForLoop();
+                else if (peek().kind == KW_DO) return parseDoWhileLoop();
+                else if (peek().kind == KW_SWITCH) return parseSwitchCaseStatement();
                 // else if (peek().lexeme.find("[]") != std::string::npos ) return parseArrayDeclaration();
-                else if (peek().lexeme == "break" || peek().lexeme == "continue") return parseTransitionOperator();
-                else if (peek().lexeme == "ArrayList") {
+                else if (peek().kind == KW_BREAK || peek().kind == KW_CONTINUE) return parseTransitionOperator();
+                else if (peek().kind == KW_ARRAYLIST) {
                     exprStatement->addChild(parseVariableArrayList());
                     return exprStatement;
                 }
-                else if (peek().lexeme == "HashMap") {
+                else if (peek().kind == KW_HASHMAP) {
                     exprStatement->addChild(parseVariableHashMap());
                     return exprStatement;
-                } else if (peek().lexeme == "return") {
+                } else if (peek().kind == KW_RETURN) {
                     exprStatement->addChild(parseReturnStatement());
                     return exprStatement;
                 }
@@ -786,15 +1162,17 @@ class Parser {
                     exprStatement->addChild(parseSystemPrint());
                     return exprStatement;
                 }
-                if (tokens[current + 1].lexeme == "=" || tokens[current + 1].lexeme == ";") {
+                if (tokens.peek(1).kind == ASSIGN || tokens.peek(1).kind == SEMICOLON) {
                     exprStatement->addChild(parseVariableAssigment());
                     return exprStatement;
                 }
-                if (tokens[current + 1].lexeme == "+=" || tokens[current + 1].lexeme == "-=") {
+                TokenKind next = tokens.peek(1).kind;
+                if (next == PLUS_ASSIGN || next == MINUS_ASSIGN || next == STAR_ASSIGN || next == SLASH_ASSIGN ||
+                    next == PERCENT_ASSIGN || next == PLUS_PLUS || next == MINUS_MINUS) {
                     exprStatement->addChild(parseExpressionStatement());
                     return exprStatement;
                 }
-                if(tokens[current + 1].lexeme == "."){
+                if(tokens.peek(1).kind == DOT){
                     exprStatement->addChild(parseMethodCall());
                     return exprStatement;
                 }
@@ -803,20 +1181,20 @@ class Parser {
                     return exprStatement;
                 // }
             }
-            if(peek().lexeme == "++" || peek().lexeme == "--"){
-                exprStatement->addChild(parseTerm());
-                match(OPERATOR, ";");
+            if(peek().kind == PLUS_PLUS || peek().kind == MINUS_MINUS){
+                exprStatement->addChild(parseExpression());
+                match(SEMICOLON);
                 return exprStatement;
             }
             return parseExpressionStatement();
         }
         
         ASTNode* parseReturnStatement(){
-            ASTNode* returnNode = new ASTNode(ASTNode::RETURN_STMT, consume().line);
-            if (!match(OPERATOR, ";")) {
+            ASTNode* returnNode = makeNode(ASTNode::RETURN_STMT, consume().loc);
+            if (!match(SEMICOLON)) {
                 returnNode->addChild(parseExpression());
             }
-            match(OPERATOR, ";");
+            match(SEMICOLON);
             return returnNode;
         }
 
@@ -824,15 +1202,15 @@ class Parser {
             Token keyword = consume();
             ASTNode* node = nullptr;
         
-            if (keyword.lexeme == "break") {
-                node = new ASTNode(ASTNode::BREAK_STMT, keyword.line);
+            if (keyword.kind == KW_BREAK) {
+                node = makeNode(ASTNode::BREAK_STMT, keyword.loc);
             } 
-            else if (keyword.lexeme == "continue") {
-                node = new ASTNode(ASTNode::CONTINUE_STMT, keyword.line);
+            else if (keyword.kind == KW_CONTINUE) {
+                node = makeNode(ASTNode::CONTINUE_STMT, keyword.loc);
             }
         
-            if (!match(OPERATOR, ";")) {
-                throw ParseException("Missing ';' after " + keyword.lexeme, keyword.line);
+            if (!match(SEMICOLON)) {
+                throw ParseException("Missing ';' after " + std::string(keyword.lexeme), keyword.loc);
             }
         
             return node;
@@ -844,209 +1222,310 @@ class Parser {
         // }
 
         ASTNode* parseSystemPrint(){
-            match(IDENTIFIER, "System");
-            match(OPERATOR, ".");
-            match(IDENTIFIER, "out");
-            match(OPERATOR, ".");
+            matchIdentifier("System");
+            match(DOT);
+            matchIdentifier("out");
+            match(DOT);
             Token print = consume();
-            match(OPERATOR, "(");
-            ASTNode* printNode = new ASTNode(ASTNode::METHOD_CALL, print.line);
-            printNode->setAttribute("name", "System.out.println");
-            match(OPERATOR, "(");
-            if(peek().lexeme != ")"){
+            match(LPAREN);
+            ASTNode* printNode = makeNode(ASTNode::METHOD_CALL, print.loc);
+            printNode->setName(intern("System.out.println"));
+            match(LPAREN);
+            if(peek().kind != RPAREN){
                 printNode->addChild(parseExpression());
             }
-            match(OPERATOR, ")");
-            match(OPERATOR, ";");
+            match(RPAREN);
+            match(SEMICOLON);
             return printNode;
         }
 
         ASTNode* parseArrayDeclaration(){
             Token type = consume();
             Token varName = consume();
-            ASTNode* array = new ASTNode(ASTNode::VARIABLE_DECL, varName.line);
-            array->setAttribute("name", varName.lexeme);
-            array->setAttribute("type", type.lexeme);
+            ASTNode* array = makeNode(ASTNode::VARIABLE_DECL, varName.loc);
+            array->setName(varName.id);
+            array->setTypeName(intern(type.lexeme));
             // ASTNode* array = new ASTNode("ArrayDeclaration", varName.lexeme);
             // array->addChild(new ASTNode("Type", type.lexeme));
-            match(OPERATOR, "=");
-            match(OPERATOR, "{");
+            match(ASSIGN);
+            match(LBRACE);
             while(true){
+                expectMore();
                 array->addChild(parseFactor());
-                if (consume().lexeme == "}") break;
+                if (consume().kind == RBRACE) break;
             }
-            match(OPERATOR, ";");
+            match(SEMICOLON);
             return array;
         }
 
-        ASTNode* parseCondition(){
-            if (tokens[current + 1].lexeme == "<" || tokens[current + 1].lexeme == ">" || tokens[current + 1].lexeme == ">=" || tokens[current + 1].lexeme == "<=" || tokens[current + 1].lexeme == "==" || tokens[current + 1].lexeme == "!=") {
-                ASTNode* left = parseTerm();
-                Token op = consume();
-                ASTNode* right = parseTerm();
-                // ASTNode* right = new ASTNode("Expression");
-                // while (true){
-                //     if(peek().lexeme == ";" || peek().lexeme == ")") break;
-                //     right->addChild(parseTerm());
-                // }
-                ASTNode* expr = new ASTNode(ASTNode::BINARY_EXPR, op.line);
-                expr->setAttribute("operator", op.lexeme);
-                // ASTNode* expr = new ASTNode("BinaryOp", op.lexeme);
-                expr->addChild(left);
-                expr->addChild(right);
-                // left = expr;
-                return expr;
-            // }
-            
-            } else if(tokens[current].type == IDENTIFIER){
-                Token t = consume();
-                ASTNode* right = new ASTNode(ASTNode::VARIABLE, t.line);
-                right->setAttribute("name", t.lexeme);
-                return right;
-            } else if(tokens[current].lexeme == "true" || tokens[current].lexeme == "false"){
-                ASTNode* right = new ASTNode(ASTNode::LITERAL, tokens[current].line);
-                Token t = consume();
-                right->setAttribute("literalType", "boolean");
-                right->setAttribute("value", t.lexeme);
-                return right;
-            } else{
-                Token t = consume();
-                throw ParseException("Обнаружена ошибка токена: " + t.lexeme, t.line);
-                return nullptr;
-            }
-        }
-
         ASTNode* parseExpressionStatement() {
             ASTNode* exprNode = parseExpression();
-            match(OPERATOR, ";");
+            match(SEMICOLON);
             return exprNode;
         }
-    
+
         ASTNode* parseExpression() {
-            ASTNode* left = parseTerm();
-            while (peek().lexeme == "+" || peek().lexeme == "-" || peek().lexeme == "+=") {
+            return parseExpression(0);
+        }
+
+        // Разбор выражения методом Пратта: после префиксной части цикл
+        // берёт операторы, связывающие не слабее minPower; правый операнд
+        // разбирается с минимумом right оператора. Каждый токен
+        // просматривается один раз, без возвратов.
+        ASTNode* parseExpression(unsigned char minPower) {
+            DepthGuard guard(*this, peek().loc);
+            ASTNode* left = parseUnary();
+            size_t postfixCount = 0;
+            while (true) {
+                TokenKind kind = peek().kind;
+                if (kind == PLUS_PLUS || kind == MINUS_MINUS) {
+                    if (POSTFIX_POWER < minPower) {
+                        break;
+                    }
+                    // Каждый постфиксный оператор вкладывает выражение ещё на уровень
+                    if (depth + ++postfixCount > maxDepth) {
+                        throw ParseException("Nesting is too deep", peek().loc);
+                    }
+                    Token op = consume();
+                    ASTNode* term = makeNode(ASTNode::UNARY_EXPR, op.loc);
+                    term->setOperator(op.kind, true);
+                    term->addChild(left);
+                    left = term;
+                    continue;
+                }
+                BindingPower power = operatorTable.infix[kind];
+                if (power.left == 0 || power.left < minPower) {
+                    break;
+                }
                 Token op = consume();
-                ASTNode* right = parseTerm();
-                ASTNode* expr = new ASTNode(ASTNode::BINARY_EXPR, op.line);
-                expr->setAttribute("operator", op.lexeme);
-                // ASTNode* expr = new ASTNode("BinaryOp", op.lexeme);
+                if (kind == QUESTION) {
+                    ASTNode* expr = makeNode(ASTNode::CONDITIONAL_EXPR, op.loc);
+                    expr->addChild(left);
+                    expr->addChild(parseExpression(0));
+                    if (!match(COLON)) {
+                        throw ParseException("Missing ':' in conditional expression", peek().loc);
+                    }
+                    expr->addChild(parseExpression(power.right));
+                    left = expr;
+                    continue;
+                }
+                ASTNode* right = parseExpression(power.right);
+                ASTNode* expr = makeNode(ASTNode::BINARY_EXPR, op.loc);
+                expr->setOperator(op.kind);
                 expr->addChild(left);
                 expr->addChild(right);
                 left = expr;
             }
             return left;
         }
-    
-        ASTNode* parseTerm() {
 
-            if(peek().lexeme == "++" || peek().lexeme == "--"){
+        // Префиксные операторы: + - ! ~ ++ --
+        ASTNode* parseUnary() {
+            TokenKind kind = peek().kind;
+            if (kind == PLUS_PLUS || kind == MINUS_MINUS || kind == PLUS || kind == MINUS ||
+                kind == NOT || kind == TILDE) {
                 Token op = consume();
-                ASTNode* right = parseFactor();
-                ASTNode* term = new ASTNode(ASTNode::UNARY_EXPR, op.line);
-                term->setAttribute("operator", op.lexeme);
-                // ASTNode* term = new ASTNode("UnaryOp", op.lexeme);
-                term->addChild(right);
+                ASTNode* operand = parseExpression(PREFIX_POWER);
+                ASTNode* term = makeNode(ASTNode::UNARY_EXPR, op.loc);
+                term->setOperator(op.kind);
+                term->addChild(operand);
                 return term;
             }
-            else {
-                ASTNode* left = parseFactor();
-
-                while (peek().lexeme == "*" || peek().lexeme == "/") {
-                    Token op = consume();
-                    ASTNode* right = parseFactor();
-                    ASTNode* term = new ASTNode(ASTNode::BINARY_EXPR, op.line);
-                    term->setAttribute("operator", op.lexeme);
-                    // ASTNode* term = new ASTNode("BinaryOp", op.lexeme);
-                    term->addChild(left);
-                    term->addChild(right);
-                    left = term;
-                }
-                return left;
-            }
+            return parseFactor();
         }
     
         ASTNode* parseFactor() {
-            if (match(OPERATOR, "(")) {
+            if (match(LPAREN)) {
                 ASTNode* expr = parseExpression();
-                match(OPERATOR, ")");
+                match(RPAREN);
                 return expr;
             }
             Token t = consume();
             if (t.type == IDENTIFIER) { 
                 if(t.lexeme.find("[") != std::string::npos){
-                    ASTNode* node = new ASTNode(ASTNode::ARRAY_ACCESS, t.line);
-                    ASTNode* var = new ASTNode(ASTNode::VARIABLE, t.line);
-                    var->setAttribute("name", t.lexeme.substr(0, t.lexeme.find("[")));
+                    ASTNode* node = makeNode(ASTNode::ARRAY_ACCESS, t.loc);
+                    ASTNode* var = makeNode(ASTNode::VARIABLE, t.loc);
+                    var->setName(intern(t.lexeme.substr(0, t.lexeme.find("["))));
                     size_t start = t.lexeme.find("[") + 1;
                     size_t end = t.lexeme.find("]");
                     size_t length = end - start;
-                    std::string index = t.lexeme.substr(start, length);
-                    ASTNode* i = new ASTNode(ASTNode::VARIABLE, t.line);
-                    i->setAttribute("name", index);
+                    std::string index(t.lexeme.substr(start, length));
+                    ASTNode* i = makeNode(ASTNode::VARIABLE, t.loc);
+                    i->setName(intern(index));
                     node->addChild(var);
                     node->addChild(i);
                     return node;
-                } else if(match(OPERATOR, ".")){
-                    ASTNode* node = new ASTNode(ASTNode::FIELD_ACCESS, t.line);
-                    ASTNode* object = new ASTNode(ASTNode::VARIABLE, t.line);
-                    object->setAttribute("name", t.lexeme);
+                } else if(match(DOT)){
+                    ASTNode* node = makeNode(ASTNode::FIELD_ACCESS, t.loc);
+                    ASTNode* object = makeNode(ASTNode::VARIABLE, t.loc);
+                    object->setName(t.id);
                     node->addChild(object);
-                    node->setAttribute("field", consume().lexeme);
+                    node->setField(consume().id);
                     return node;
                 } else{
-                    ASTNode* node = new ASTNode(ASTNode::VARIABLE, t.line);
-                    node->setAttribute("name", t.lexeme);
+                    ASTNode* node = makeNode(ASTNode::VARIABLE, t.loc);
+                    node->setName(t.id);
                     return node;
                 }
             }
             else if (t.type == NUMBER) {
-                ASTNode* node = new ASTNode(ASTNode::LITERAL, t.line);
-                node->setAttribute("literalType", "int");
-                node->setAttribute("value", t.lexeme);
+                ASTNode* node = makeNode(ASTNode::LITERAL, t.loc);
+                node->setLiteral(ASTNode::INT_LITERAL, t.lexeme);
                 return node;
             }
             else if (t.type == FLOAT_NUMBER) {
-                ASTNode* node = new ASTNode(ASTNode::LITERAL, t.line);
-                node->setAttribute("literalType", "float");
-                node->setAttribute("value", t.lexeme);
+                ASTNode* node = makeNode(ASTNode::LITERAL, t.loc);
+                node->setLiteral(ASTNode::FLOAT_LITERAL, t.lexeme);
                 return node;
             }
             else if (t.type == CHAR_LITERAL) {
-                ASTNode* node = new ASTNode(ASTNode::LITERAL, t.line);
-                node->setAttribute("literalType", "char");
-                node->setAttribute("value", t.lexeme);
+                ASTNode* node = makeNode(ASTNode::LITERAL, t.loc);
+                node->setLiteral(ASTNode::CHAR_LITERAL, t.lexeme);
                 return node;
             }
             else if (t.type == STRING_LITERAL) {
-                ASTNode* node = new ASTNode(ASTNode::LITERAL, t.line);
-                node->setAttribute("literalType", "string");
-                node->setAttribute("value", t.lexeme);
+                ASTNode* node = makeNode(ASTNode::LITERAL, t.loc);
+                node->setLiteral(ASTNode::STRING_LITERAL, t.lexeme);
                 return node;
                 // return new ASTNode("String_literal", t.line);
             }
             // else if (t.lexeme == ".") return new ASTNode("Operator", t.line);
-            else if (t.lexeme == "true" || t.lexeme == "false") {
-                ASTNode* node = new ASTNode(ASTNode::LITERAL, t.line);
-                node->setAttribute("literalType", "boolean");
-                node->setAttribute("value", t.lexeme);
+            else if (t.kind == KW_TRUE || t.kind == KW_FALSE) {
+                ASTNode* node = makeNode(ASTNode::LITERAL, t.loc);
+                node->setLiteral(ASTNode::BOOLEAN_LITERAL, t.lexeme);
                 return node;
                 // return new ASTNode("Boolean_literal", t.line);
             }
-            throw ParseException("Обнаружена ошибка токена: " + t.lexeme, t.line);
+            throw ParseException("Обнаружена ошибка токена: " + std::string(t.lexeme), t.loc);
             return nullptr;
         }
     };
 
-int main() {
-    std::vector<Token> tokens = readTokensFromFile("D:\\Study\\6_semestr\\MTran\\output.txt");
+int main(int argc, char* argv[]) {
+    // main <file.java>        - лексер работает в этом же процессе
+    // main --tokens [file]    - токены из файла лексера Lab2 (output.tok или output.txt)
+    // --parallel              - тела методов разбираются на всех ядрах
+    // --lazy                  - разбираются только тела методов, достижимых из main
+    // --cache                 - дерево разбора берётся из file.mtast, если исходник не менялся
+    // --dump-ast=text|json|dot - вывод дерева разбора (по умолчанию не выводится)
+    // --max-depth=N           - предел вложенности для парсера (по умолчанию 1000);
+    //                           более глубокий вход отвергается ошибкой разбора.
+    //                           Парсер рекурсивен, поэтому большой предел
+    //                           требует большого стека
+    std::string defaultTokenFile = "D:\\Study\\6_semestr\\MTran\\output.tok";
+    bool fromTokens = argc == 1;
+    bool parallel = false;
+    bool lazy = false;
+    bool useCache = false;
+    bool dumpTree = false;
+    AstDumpFormat dumpFormat = AstDumpFormat::TEXT;
+    size_t maxDepth = Parser::DEFAULT_MAX_DEPTH;
+    std::string inputPath;
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--tokens") fromTokens = true;
+        else if (option == "--parallel") parallel = true;
+        else if (option == "--lazy") lazy = true;
+        else if (option == "--cache") useCache = true;
+        else if (option == "--dump-ast") dumpTree = true;
+        else if (option.compare(0, 11, "--dump-ast=") == 0) {
+            if (!parseAstDumpFormat(std::string_view(option).substr(11), dumpFormat)) {
+                std::cerr << "Unknown AST dump format " << option.substr(11) << std::endl;
+                return 1;
+            }
+            dumpTree = true;
+        }
+        else if (option.compare(0, 12, "--max-depth=") == 0) {
+            const char* first = option.data() + 12;
+            const char* last = option.data() + option.size();
+            std::from_chars_result parsed = std::from_chars(first, last, maxDepth);
+            if (parsed.ec != std::errc() || parsed.ptr != last || first == last || maxDepth == 0) {
+                std::cerr << "Invalid nesting limit " << option.substr(12) << std::endl;
+                return 1;
+            }
+        }
+        else if (option.compare(0, 2, "--") == 0) {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+        else inputPath = option;
+    }
+    if (fromTokens && inputPath.empty()) {
+        inputPath = defaultTokenFile;
+    }
 
-    Parser parser(tokens);
+    MappedFile inputFile;
+    std::unique_ptr<Lexer> lexer;
+    std::unique_ptr<TokenSource> tokens;
+    std::vector<Token> allTokens; // весь вход для параллельного и ленивого разбора
+    bool wholeInput = parallel || lazy;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    // Дерево целиком освобождается вместе с ареной в конце main
+    AstArena astArena;
     ASTNode* ast = nullptr;
+    std::string cachePath; // пустой - кэш не используется
+    uint64_t cacheKey = 0;
+    if (!fromTokens) {
+        if (!inputFile.open(inputPath)) {
+            std::cerr << "Ошибка открытия файла: " << inputPath << std::endl;
+            return 1;
+        }
+        if (useCache) {
+            // Ленивый разбор даёт другое дерево, а от предела вложенности
+            // зависит, разберётся ли вход, поэтому оба входят в ключ
+            cachePath = astCachePath(inputPath);
+            cacheKey = astCacheKey(inputFile.view(), maxDepth, lazy);
+            MappedFile cacheFile;
+            FlatAst cached;
+            if (cacheFile.open(cachePath) && loadAstCache(cacheFile.view(), cacheKey, cached, LineTable::global())) {
+                ast = cached.toTree(astArena);
+            }
+        }
+        if (ast) {
+            // Попадание в кэш: лексер и парсер не запускаются
+        } else if (wholeInput) {
+            allTokens = tokenizeParallel(inputFile.view(), threads);
+        } else {
+            // Лексер разбирает токены по мере того, как их запрашивает парсер
+            lexer.reset(new Lexer(inputFile.view()));
+            tokens.reset(new LexerTokenSource(*lexer));
+        }
+    } else {
+        std::vector<Token> fileTokens;
+        if (!readTokens(inputPath, inputFile, fileTokens)) {
+            return 1;
+        }
+        if (wholeInput) {
+            allTokens = std::move(fileTokens);
+        } else {
+            tokens.reset(new VectorTokenSource(std::move(fileTokens)));
+        }
+    }
+    if (wholeInput) {
+        tokens.reset(new SpanTokenSource(allTokens.data(), allTokens.data() + allTokens.size()));
+    }
+
     try {
-        ast = parser.parseProgram();
-        ast->print();
+        if (!ast) {
+            Parser parser(*tokens, astArena, maxDepth);
+            if (lazy) {
+                ast = parser.parseProgramLazy(allTokens);
+            } else if (parallel) {
+                ast = parser.parseProgramParallel(allTokens, threads);
+            } else {
+                ast = parser.parseProgram();
+            }
+            if (!cachePath.empty() && !saveAstCache(cachePath, cacheKey, FlatAst::fromTree(ast), LineTable::global())) {
+                std::cerr << "Не удалось записать кэш дерева: " << cachePath << std::endl;
+            }
+        }
+        if (dumpTree) {
+            DumpWriter out(stdout);
+            dumpAst(ast, dumpFormat, out);
+        }
     } catch (const ParseException& e) {
-        std::cout << "Ошибка: " << e.what() << " в строке " << e.getLine() << std::endl;
+        std::cout << "Ошибка: " << e.what() << " в строке " << LineTable::global().format(e.getLoc()) << std::endl;
+        return 1;
     } 
     SemanticAnalyzer sm_analyzer = SemanticAnalyzer();
     try{
@@ -1088,7 +1567,5 @@ int main() {
         std::cerr << error.what() << std::endl;
     }
 
-    
-    delete ast;
     return 0;
 }
\ No newline at end of file
@@ -1,100 +1,167 @@
 #include "utils.hpp"
+#include "../Lab2/headers/unicode.hpp"
 
 // Type
-Type::Type(Kind kind, PrimitiveKind primitiveKind, const std::string& className)
-    : kind(kind), primitiveKind(primitiveKind), className(className), arrayDimension(0) {}
-
-Type Type::voidType() { return Type(VOID); }
-Type Type::booleanType() { return Type(PRIMITIVE, BOOLEAN); }
-Type Type::charType() { return Type(PRIMITIVE, CHAR); }
-Type Type::intType() { return Type(PRIMITIVE, INT); }
-Type Type::floatType() { return Type(PRIMITIVE, FLOAT); }
-Type Type::doubleType() { return Type(PRIMITIVE, DOUBLE); }
-Type Type::stringType() { return Type(PRIMITIVE, STRING); }
+
+namespace {
+
+const TypeTable::Entry& entryOf(TypeId id) {
+    return TypeTable::global().entry(id);
+}
+
+SymbolId typeName(const std::string& name) {
+    return name.empty() ? NO_SYMBOL : Interner::global().intern(name);
+}
+
+} // namespace
+
+// void и примитивы заранее лежат в таблице под постоянными номерами
+Type::Type(Kind kind, PrimitiveKind primitiveKind, const std::string& className) {
+    if (className.empty() && kind == PRIMITIVE) {
+        id = TypeTable::primitiveId(primitiveKind);
+        return;
+    }
+    if (className.empty() && kind == VOID && primitiveKind == BOOLEAN) {
+        id = TypeTable::VOID_ID;
+        return;
+    }
+    TypeTable::Entry key;
+    key.kind = kind;
+    key.primitiveKind = primitiveKind;
+    key.className = typeName(className);
+    id = TypeTable::global().intern(key);
+}
+
+Type Type::voidType() { return Type(TypeTable::VOID_ID); }
+Type Type::booleanType() { return Type(TypeTable::primitiveId(BOOLEAN)); }
+Type Type::charType() { return Type(TypeTable::primitiveId(CHAR)); }
+Type Type::intType() { return Type(TypeTable::primitiveId(INT)); }
+Type Type::floatType() { return Type(TypeTable::primitiveId(FLOAT)); }
+Type Type::doubleType() { return Type(TypeTable::primitiveId(DOUBLE)); }
+Type Type::stringType() { return Type(TypeTable::primitiveId(STRING)); }
+// Массив хранит имя класса или вид примитива элемента, как и прежде
 Type Type::arrayType(const Type& baseType, int dimension) {
-    Type type = baseType;
-    type.kind = ARRAY;
-    type.arrayDimension = dimension;
-    return type;
+    TypeTable& table = TypeTable::global();
+    TypeTable::Entry key = table.entry(baseType.id);
+    key.kind = ARRAY;
+    key.arrayDimension = dimension;
+    return Type(table.intern(key));
 }
 Type Type::genericParamType(const std::string& paramName) {
-    Type type(GENERIC_PARAM);
-    type.genericParamName = paramName;
-    return type;
+    TypeTable::Entry key;
+    key.kind = GENERIC_PARAM;
+    key.genericParamName = typeName(paramName);
+    return Type(TypeTable::global().intern(key));
 }
 Type Type::genericType(const Type& baseType, const std::vector<Type>& typeArgs) {
-    Type type(GENERIC_INSTANCE);
-    type.genericBaseType = std::make_shared<Type>(baseType);
-    type.genericTypeArguments = typeArgs;
-    return type;
+    TypeTable::Entry key;
+    key.kind = GENERIC_INSTANCE;
+    key.genericBase = baseType.id;
+    std::vector<TypeId> args;
+    args.reserve(typeArgs.size());
+    for (const Type& arg : typeArgs) {
+        args.push_back(arg.id);
+    }
+    return Type(TypeTable::global().intern(key, args));
 }
 Type Type::classType(const std::string& name) {
     return Type(CLASS, BOOLEAN, name);
 }
 
-bool Type::isVoid() const { return kind == VOID; }
-bool Type::isPrimitive() const { return kind == PRIMITIVE; }
-bool Type::isArray() const { return kind == ARRAY; }
-bool Type::isClass() const { return kind == CLASS || kind == GENERIC_INSTANCE; }
-bool Type::isBoolean() const { return kind == PRIMITIVE && primitiveKind == BOOLEAN; }
+bool Type::isVoid() const { return entryOf(id).kind == VOID; }
+bool Type::isPrimitive() const { return entryOf(id).kind == PRIMITIVE; }
+bool Type::isArray() const { return entryOf(id).kind == ARRAY; }
+bool Type::isClass() const {
+    Kind kind = entryOf(id).kind;
+    return kind == CLASS || kind == GENERIC_INSTANCE;
+}
+bool Type::isBoolean() const {
+    const TypeTable::Entry& e = entryOf(id);
+    return e.kind == PRIMITIVE && e.primitiveKind == BOOLEAN;
+}
 bool Type::isNumeric() const {
-    return (kind == PRIMITIVE && (primitiveKind == INT || primitiveKind == FLOAT || primitiveKind == DOUBLE)) || className == "Integer";
+    const TypeTable::Entry& e = entryOf(id);
+    return (e.kind == PRIMITIVE && (e.primitiveKind == INT || e.primitiveKind == FLOAT || e.primitiveKind == DOUBLE)) ||
+           (e.className != NO_SYMBOL && e.className == TypeTable::global().integerName());
 }
 bool Type::isInt() const {
-    return (kind == PRIMITIVE && primitiveKind == INT) || className == "Integer";
+    const TypeTable::Entry& e = entryOf(id);
+    return (e.kind == PRIMITIVE && e.primitiveKind == INT) ||
+           (e.className != NO_SYMBOL && e.className == TypeTable::global().integerName());
 }
 bool Type::isChar() const {
-    return kind == PRIMITIVE && primitiveKind == CHAR;
+    const TypeTable::Entry& e = entryOf(id);
+    return e.kind == PRIMITIVE && e.primitiveKind == CHAR;
+}
+bool Type::isString() const {
+    const TypeTable::Entry& e = entryOf(id);
+    return e.kind == PRIMITIVE && e.primitiveKind == STRING;
 }
-bool Type::isString() const { return kind == PRIMITIVE && primitiveKind == STRING; }
-bool Type::isGenericParam() const { return kind == GENERIC_PARAM; }
-bool Type::isGenericInstance() const { return kind == GENERIC_INSTANCE; }
+bool Type::isGenericParam() const { return entryOf(id).kind == GENERIC_PARAM; }
+bool Type::isGenericInstance() const { return entryOf(id).kind == GENERIC_INSTANCE; }
 
 Type Type::getElementType() const {
     if (!isArray()) return *this;
-    Type result = *this;
-    result.arrayDimension--;
-    if (result.arrayDimension == 0) {
-        result.kind = (result.className.empty()) ? PRIMITIVE : CLASS;
+    TypeTable& table = TypeTable::global();
+    TypeTable::Entry key = table.entry(id);
+    key.arrayDimension--;
+    if (key.arrayDimension == 0) {
+        key.kind = key.className == NO_SYMBOL ? PRIMITIVE : CLASS;
     }
-    return result;
+    return Type(table.intern(key));
 }
 
 Type Type::getGenericBaseType() const {
     if (!isGenericInstance()) throw std::runtime_error("Not a generic instance");
-    return *genericBaseType;
+    return Type(entryOf(id).genericBase);
 }
 
 std::vector<Type> Type::getGenericArguments() const {
     if (!isGenericInstance()) throw std::runtime_error("Not a generic instance");
-    return genericTypeArguments;
+    std::vector<Type> result;
+    for (TypeId arg : TypeTable::global().argumentsOf(entryOf(id))) {
+        result.push_back(Type(arg));
+    }
+    return result;
 }
 
 std::string Type::getGenericParamName() const {
     if (!isGenericParam()) throw std::runtime_error("Not a generic parameter");
-    return genericParamName;
+    return std::string(Interner::global().name(entryOf(id).genericParamName));
 }
 
 bool Type::isAssignableTo(const Type& other) const {
     if (*this == other) return true;
 
+    const TypeTable::Entry& self = entryOf(id);
+    const TypeTable::Entry& target = entryOf(other.id);
     if (isNumeric() && other.isNumeric()) {
-        if (primitiveKind == INT && (other.primitiveKind == FLOAT || other.primitiveKind == DOUBLE))
+        if (self.primitiveKind == INT && (target.primitiveKind == FLOAT || target.primitiveKind == DOUBLE))
             return true;
-        if (primitiveKind == FLOAT && other.primitiveKind == DOUBLE)
+        if (self.primitiveKind == FLOAT && target.primitiveKind == DOUBLE)
             return true;
     }
 
-    if ((isInt() && other.toString() == "Integer") ||
-        (toString() == "Integer" && other.isInt()) || 
-        (toString() == "Integer" && other.toString() == "Integer")) 
-    {
+    TypeId integer = TypeTable::global().integerClass();
+    bool selfInteger = id == integer;
+    bool targetInteger = other.id == integer;
+    if ((isInt() && targetInteger) || (selfInteger && other.isInt()) || (selfInteger && targetInteger)) {
         return true;
     }
 
     if (isGenericInstance() && other.isGenericInstance()) {
-        return genericBaseType->isAssignableTo(other.getGenericBaseType()) &&
-               genericTypeArguments == other.genericTypeArguments;
+        if (!Type(self.genericBase).isAssignableTo(Type(target.genericBase)) ||
+            self.argumentCount != target.argumentCount) {
+            return false;
+        }
+        std::vector<TypeId> selfArgs = TypeTable::global().argumentsOf(self);
+        std::vector<TypeId> targetArgs = TypeTable::global().argumentsOf(target);
+        for (size_t i = 0; i < selfArgs.size(); i++) {
+            if (Type(selfArgs[i]) != Type(targetArgs[i])) {
+                return false;
+            }
+        }
+        return true;
     }
 
     if (isArray() && other.isArray()) {
@@ -106,58 +173,177 @@ bool Type::isAssignableTo(const Type& other) const {
     }
 
     if (isClass() && other.isClass()) {
-        return className == other.className;
+        return self.className == target.className;
     }
 
     return false;
 }
 
+// Равные типы приведены таблицей к одному номеру. Обобщённые типы, как
+// и раньше, не равны даже самим себе.
 bool Type::operator==(const Type& other) const {
-    if (kind != other.kind) return false;
-    
-    switch (kind) {
-        case VOID: return true;
-        case PRIMITIVE: return primitiveKind == other.primitiveKind;
-        case ARRAY: 
-            return arrayDimension == other.arrayDimension && 
-                   getElementType() == other.getElementType();
-        case CLASS: return className == other.className;
-    }
-    
-    return false;
+    if (id != other.id) return false;
+    Kind kind = entryOf(id).kind;
+    return kind != GENERIC_PARAM && kind != GENERIC_INSTANCE;
 }
 
 bool Type::operator!=(const Type& other) const {
     return !(*this == other);
 }
 
-std::string Type::toString() const {
-    switch (kind) {
-        case VOID: return "void";
-        case PRIMITIVE:
-            switch (primitiveKind) {
-                case BOOLEAN: return "boolean";
-                case CHAR: return "char";
-                case INT: return "int";
-                case FLOAT: return "float";
-                case DOUBLE: return "double";
-                case STRING: return "String";
+const std::string& Type::toString() const {
+    return TypeTable::global().text(id);
+}
+
+
+// TypeTable
+
+TypeTable::TypeTable() {
+    slots.assign(INITIAL_SLOTS, NO_TYPE);
+    Entry key;
+    intern(key); // VOID_ID
+    key.kind = Type::PRIMITIVE;
+    for (int kind = Type::BOOLEAN; kind <= Type::STRING; kind++) {
+        key.primitiveKind = static_cast<Type::PrimitiveKind>(kind);
+        intern(key);
+    }
+    integerNameId = Interner::global().intern("Integer");
+    Entry integer;
+    integer.kind = Type::CLASS;
+    integer.className = integerNameId;
+    integerClassId = intern(integer);
+}
+
+TypeId TypeTable::intern(const Entry& fields, const std::vector<TypeId>& fieldArgs) {
+    static const std::vector<TypeId> noArgs;
+    Entry key = canonical(fields);
+    const std::vector<TypeId>& args = key.kind == Type::GENERIC_INSTANCE ? fieldArgs : noArgs;
+    uint64_t hash = hashOf(key, args);
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        TypeId id = slots[i];
+        if (id == NO_TYPE) {
+            break;
+        }
+        if (hashes[id] == hash && sameKey(entries[id], key, args)) {
+            return id;
+        }
+    }
+
+    TypeId id = static_cast<TypeId>(entries.size());
+    key.firstArgument = static_cast<uint32_t>(arguments.size());
+    key.argumentCount = static_cast<uint32_t>(args.size());
+    arguments.insert(arguments.end(), args.begin(), args.end());
+    entries.push_back(key);
+    texts.emplace_back();
+    hashes.push_back(hash);
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        if (slots[i] == NO_TYPE) {
+            slots[i] = id;
+            break;
+        }
+    }
+    if (entries.size() * 4 > slots.size() * 3) {
+        grow();
+    }
+    // Текст строится после добавления: для массива он требует тип элемента
+    std::string text = buildText(id);
+    texts[id] = std::move(text);
+    return id;
+}
+
+std::vector<TypeId> TypeTable::argumentsOf(const Entry& entry) const {
+    return std::vector<TypeId>(arguments.begin() + entry.firstArgument,
+                               arguments.begin() + entry.firstArgument + entry.argumentCount);
+}
+
+TypeTable& TypeTable::global() {
+    static TypeTable instance;
+    return instance;
+}
+
+// Оставляет только поля, по которым прежние правила различали типы:
+// примитив - вид, класс - имя, массив - размерность и имя класса или вид
+// примитива элемента, параметр - имя, экземпляр - базовый тип и аргументы
+TypeTable::Entry TypeTable::canonical(const Entry& fields) {
+    Entry key;
+    key.kind = fields.kind;
+    switch (fields.kind) {
+        case Type::PRIMITIVE:
+            key.primitiveKind = fields.primitiveKind;
+            break;
+        case Type::CLASS:
+            key.className = fields.className;
+            break;
+        case Type::ARRAY:
+            key.arrayDimension = fields.arrayDimension;
+            key.className = fields.className;
+            if (fields.className == NO_SYMBOL) {
+                key.primitiveKind = fields.primitiveKind;
+            }
+            break;
+        case Type::GENERIC_PARAM:
+            key.genericParamName = fields.genericParamName;
+            break;
+        case Type::GENERIC_INSTANCE:
+            key.genericBase = fields.genericBase;
+            break;
+        default:
+            break;
+    }
+    return key;
+}
+
+uint64_t TypeTable::hashOf(const Entry& key, const std::vector<TypeId>& args) {
+    uint64_t fields[6] = {static_cast<uint64_t>(key.kind) << 32 | key.primitiveKind, key.className,
+                          static_cast<uint64_t>(static_cast<uint32_t>(key.arrayDimension)),
+                          key.genericParamName, key.genericBase, args.size()};
+    uint64_t hash = 14695981039346656037ull; // FNV-1a по полям
+    for (uint64_t field : fields) {
+        hash = (hash ^ field) * 1099511628211ull;
+    }
+    for (TypeId arg : args) {
+        hash = (hash ^ arg) * 1099511628211ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+bool TypeTable::sameKey(const Entry& entry, const Entry& key, const std::vector<TypeId>& args) const {
+    return entry.kind == key.kind && entry.primitiveKind == key.primitiveKind &&
+           entry.className == key.className && entry.arrayDimension == key.arrayDimension &&
+           entry.genericParamName == key.genericParamName && entry.genericBase == key.genericBase &&
+           entry.argumentCount == args.size() &&
+           std::equal(args.begin(), args.end(), arguments.begin() + entry.firstArgument);
+}
+
+std::string TypeTable::buildText(TypeId id) const {
+    const Entry& entry = entries[id];
+    switch (entry.kind) {
+        case Type::VOID: return "void";
+        case Type::PRIMITIVE:
+            switch (entry.primitiveKind) {
+                case Type::BOOLEAN: return "boolean";
+                case Type::CHAR: return "char";
+                case Type::INT: return "int";
+                case Type::FLOAT: return "float";
+                case Type::DOUBLE: return "double";
+                case Type::STRING: return "String";
                 default: return "unknown";
             }
-        case ARRAY: {
-            std::string result = getElementType().toString();
-            for (int i = 0; i < arrayDimension; i++) {
+        case Type::ARRAY: {
+            std::string result = Type(id).getElementType().toString();
+            for (int i = 0; i < entry.arrayDimension; i++) {
                 result += "[]";
             }
             return result;
         }
-        case CLASS: return className;
-        case GENERIC_PARAM: return genericParamName;
-        case GENERIC_INSTANCE: {
-            std::string result = genericBaseType->toString() + "<";
-            for (size_t i = 0; i < genericTypeArguments.size(); ++i) {
+        case Type::CLASS: return std::string(Interner::global().name(entry.className));
+        case Type::GENERIC_PARAM: return std::string(Interner::global().name(entry.genericParamName));
+        case Type::GENERIC_INSTANCE: {
+            std::string result = texts[entry.genericBase] + "<";
+            for (uint32_t i = 0; i < entry.argumentCount; ++i) {
                 if (i > 0) result += ", ";
-                result += genericTypeArguments[i].toString();
+                result += texts[arguments[entry.firstArgument + i]];
             }
             result += ">";
             std::size_t index = result.find("<>");
@@ -168,15 +354,32 @@ std::string Type::toString() const {
     }
 }
 
+void TypeTable::grow() {
+    slots.assign(slots.size() * 2, NO_TYPE);
+    size_t mask = slots.size() - 1;
+    for (TypeId id = 0; id < entries.size(); id++) {
+        for (size_t i = hashes[id] & mask;; i = (i + 1) & mask) {
+            if (slots[i] == NO_TYPE) {
+                slots[i] = id;
+                break;
+            }
+        }
+    }
+}
+
 
 // Symbol
 
 Symbol::Symbol(const std::string& name, const Type& type, Kind kind)
-    : name(name), type(type), kind(kind) {}
+    : id(Interner::global().intern(name)), type(type), kind(kind) {}
+
+Symbol::Symbol(SymbolId id, const Type& type, Kind kind)
+    : id(id), type(type), kind(kind) {}
 
 Symbol::~Symbol() {}
 
-const std::string& Symbol::getName() const { return name; }
+SymbolId Symbol::getId() const { return id; }
+std::string_view Symbol::getName() const { return Interner::global().name(id); }
 const Type& Symbol::getType() const { return type; }
 Symbol::Kind Symbol::getKind() const { return kind; }
 
@@ -210,7 +413,7 @@ const Type& FunctionSymbol::getParameterType(size_t index) const {
 // ClassSymbol
 
 ClassSymbol::ClassSymbol(const std::string& name)
-    : Symbol(name, Type::classType(name), CLASS), symbolTable(new SymbolTable(nullptr)) {}
+    : Symbol(name, Type::classType(name), CLASS), symbolTable(new SymbolTable()) {}
 
 SymbolTable* ClassSymbol::getSymbolTable() const { return symbolTable.get(); }
 
@@ -219,107 +422,426 @@ void ClassSymbol::addGenericParam(const std::string& param) { genericParams.push
 bool ClassSymbol::isGenericClass() const { return isGeneric; }
 std::vector<std::string> ClassSymbol::getGenericParams() const { return genericParams; }
 
-SymbolTable::SymbolTable(SymbolTable* parent) : parent(parent) {}
-
 void SymbolTable::define(Symbol* symbol) {
-    symbols[symbol->getName()] = std::unique_ptr<Symbol>(symbol);
+    symbols[symbol->getId()] = std::unique_ptr<Symbol>(symbol);
+}
+
+Symbol* SymbolTable::resolve(SymbolId id) const {
+    return resolveLocally(id);
 }
 
 Symbol* SymbolTable::resolve(const std::string& name) const {
-    auto it = symbols.find(name);
+    SymbolId id = Interner::global().find(name);
+    return id == NO_SYMBOL ? nullptr : resolve(id);
+}
+
+Symbol* SymbolTable::resolveLocally(SymbolId id) const {
+    auto it = symbols.find(id);
     if (it != symbols.end()) {
         return it->second.get();
     }
-    
-    if (parent) {
-        return parent->resolve(name);
-    }
-    
     return nullptr;
 }
 
 Symbol* SymbolTable::resolveLocally(const std::string& name) const {
-    auto it = symbols.find(name);
-    if (it != symbols.end()) {
-        return it->second.get();
+    SymbolId id = Interner::global().find(name);
+    return id == NO_SYMBOL ? nullptr : resolveLocally(id);
+}
+
+
+// ScopedSymbolTable
+
+ScopedSymbolTable::ScopedSymbolTable() {
+    slots.assign(INITIAL_SLOTS, Slot{NO_SYMBOL, NO_BINDING});
+}
+
+void ScopedSymbolTable::enterScope() {
+    scopeStarts.push_back(static_cast<uint32_t>(bindings.size()));
+}
+
+void ScopedSymbolTable::exitScope() {
+    if (scopeStarts.empty()) {
+        return;
     }
-    return nullptr;
+    uint32_t start = scopeStarts.back();
+    scopeStarts.pop_back();
+    while (bindings.size() > start) {
+        Binding& binding = bindings.back();
+        slots[findSlot(binding.symbol->getId())].top = binding.shadowed;
+        bindings.pop_back();
+    }
+}
+
+size_t ScopedSymbolTable::depth() const {
+    return scopeStarts.size();
+}
+
+void ScopedSymbolTable::define(Symbol* symbol) {
+    SymbolId id = symbol->getId();
+    size_t index = findSlot(id);
+    if (slots[index].id == NO_SYMBOL) {
+        slots[index].id = id;
+        if (++usedSlots * 4 > slots.size() * 3) {
+            grow();
+            index = findSlot(id);
+        }
+    }
+    uint32_t binding = static_cast<uint32_t>(bindings.size());
+    bindings.push_back(Binding{std::unique_ptr<Symbol>(symbol), slots[index].top,
+                               static_cast<uint32_t>(scopeStarts.size())});
+    slots[index].top = binding;
+}
+
+Symbol* ScopedSymbolTable::resolve(SymbolId id) const {
+    uint32_t top = slots[findSlot(id)].top;
+    return top == NO_BINDING ? nullptr : bindings[top].symbol.get();
 }
 
-SymbolTable* SymbolTable::getParent() const { return parent; }
+Symbol* ScopedSymbolTable::resolveLocally(SymbolId id) const {
+    uint32_t top = slots[findSlot(id)].top;
+    if (top == NO_BINDING || bindings[top].scope != scopeStarts.size()) {
+        return nullptr;
+    }
+    return bindings[top].symbol.get();
+}
+
+// Ячейка имени id или пустая ячейка, куда его следует поместить. Ячейки
+// однажды встреченных имён не освобождаются, поэтому удалений в таблице нет
+size_t ScopedSymbolTable::findSlot(SymbolId id) const {
+    size_t mask = slots.size() - 1;
+    for (size_t i = (id * 2654435761u) & mask;; i = (i + 1) & mask) {
+        if (slots[i].id == id || slots[i].id == NO_SYMBOL) {
+            return i;
+        }
+    }
+}
+
+void ScopedSymbolTable::grow() {
+    std::vector<Slot> old(slots.size() * 2, Slot{NO_SYMBOL, NO_BINDING});
+    old.swap(slots);
+    for (const Slot& slot : old) {
+        if (slot.id != NO_SYMBOL) {
+            slots[findSlot(slot.id)] = slot;
+        }
+    }
+}
 
 
 // SemanticError
 
-SemanticError::SemanticError(const std::string& message, int line)
-    : std::runtime_error(buildMessage(message, line)),
-      line(line), message(message) {}
+SemanticError::SemanticError(const std::string& message, SourceLoc loc)
+    : std::runtime_error(buildMessage(message, loc)),
+      loc(loc), message(message) {}
 
-std::string SemanticError::buildMessage(const std::string& message, int line) {
-    return "Semantic error at " + std::to_string(line) + " - " + message;
+std::string SemanticError::buildMessage(const std::string& message, SourceLoc loc) {
+    return "Semantic error at " + LineTable::global().format(loc) + " - " + message;
 }
 
-int SemanticError::getLine() const { return line; }
+SourceLoc SemanticError::getLoc() const { return loc; }
 const std::string& SemanticError::getErrorMessage() const { return message; }
 
 
-// ASTNode
+// AstArena
 
-ASTNode::ASTNode(NodeType type, int line)
-    : type(type), line(line) {}
+void AstArena::addBlock(size_t minimum) {
+    size_t size = std::max(BLOCK_SIZE, minimum);
+    blocks.emplace_back(new char[size]);
+    blockSizes.push_back(size);
+    current = blocks.back().get();
+    used = 0;
+    capacity = size;
+}
 
-ASTNode::~ASTNode() {
-    for (auto child : children) {
-        delete child;
+std::string_view AstArena::copy(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
     }
+    char* data = allocateArray<char>(text.size());
+    std::memcpy(data, text.data(), text.size());
+    return std::string_view(data, text.size());
 }
 
+AstArena& AstArena::spawn() {
+    spawned.emplace_back(new AstArena());
+    return *spawned.back();
+}
+
+size_t AstArena::bytesAllocated() const {
+    size_t total = 0;
+    for (size_t size : blockSizes) {
+        total += size;
+    }
+    for (const auto& arena : spawned) {
+        total += arena->bytesAllocated();
+    }
+    return total;
+}
+
+
+// ASTNode
+
+ASTNode::ASTNode(NodeType type, SourceLoc loc, AstArena& arena)
+    : type(type), loc(loc), name(NO_SYMBOL), arena(&arena) {}
+
 ASTNode::NodeType ASTNode::getType() const { return type; }
-int ASTNode::getLine() const { return line; }
+SourceLoc ASTNode::getLoc() const { return loc; }
 
 void ASTNode::addChild(ASTNode* child) {
-    children.push_back(child);
+    if (childCount == childCapacity) {
+        uint32_t grown = childCapacity == 0 ? 4 : childCapacity * 2;
+        ASTNode** moved = arena->allocateArray<ASTNode*>(grown);
+        std::copy(children, children + childCount, moved);
+        children = moved;
+        childCapacity = grown;
+    }
+    children[childCount++] = child;
 }
 
 ASTNode* ASTNode::getChild(size_t index) const {
-    if (index < children.size()) {
+    if (index < childCount) {
         return children[index];
     }
     return nullptr;
 }
 
 size_t ASTNode::getChildCount() const {
-    return children.size();
+    return childCount;
 }
 
-void ASTNode::print(const std::string& prefix, bool isLast) {
-    std::cout << prefix;
+namespace {
+
+const char* literalKindName(ASTNode::LiteralKind kind) {
+    switch (kind) {
+        case ASTNode::INT_LITERAL: return "int";
+        case ASTNode::FLOAT_LITERAL: return "float";
+        case ASTNode::CHAR_LITERAL: return "char";
+        case ASTNode::STRING_LITERAL: return "string";
+        case ASTNode::BOOLEAN_LITERAL: return "boolean";
+        default: return "";
+    }
+}
+
+// Код символа из литерала вида 'a', '\n' или 'ф'
+int64_t parseCharLiteral(std::string_view text) {
+    if (text.size() < 3 || text.front() != '\'') {
+        return 0;
+    }
+    if (text[1] == '\\') {
+        switch (text[2]) {
+            case 'n': return '\n';
+            case 't': return '\t';
+            case 'r': return '\r';
+            case 'b': return '\b';
+            case 'f': return '\f';
+            case '0': return 0;
+            default: return static_cast<unsigned char>(text[2]);
+        }
+    }
+    char32_t codePoint = 0;
+    if (decodeUtf8(text.data(), 1, text.size() - 1, codePoint) == 0) {
+        return static_cast<unsigned char>(text[1]);
+    }
+    return codePoint;
+}
 
-    std::cout << (isLast ? "└── " : "├── ");
-    std::string attrs = "";
-    for(auto attr: attributes){
-        attrs += attr.second + ", ";
+// Значение целого литерала Java: 0x/0X - шестнадцатеричный, 0b/0B -
+// двоичный, ведущий 0 - восьмеричный; '_' между цифрами и суффикс L
+// пропускаются. Знак, который лексер приклеивает к числу, учитывается.
+// Значения за пределами 64 бит берутся по модулю, как при приведении в Java
+int64_t parseIntLiteral(std::string_view text) {
+    bool negative = false;
+    if (!text.empty() && (text.front() == '-' || text.front() == '+')) {
+        negative = text.front() == '-';
+        text.remove_prefix(1);
+    }
+    std::string digits;
+    digits.reserve(text.size());
+    for (char c : text) {
+        if (c != '_') {
+            digits += c;
+        }
+    }
+    if (!digits.empty() && (digits.back() == 'L' || digits.back() == 'l')) {
+        digits.pop_back();
+    }
+    int base = 10;
+    size_t start = 0;
+    if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+        base = 16;
+        start = 2;
+    } else if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'b' || digits[1] == 'B')) {
+        base = 2;
+        start = 2;
+    } else if (digits.size() > 1 && digits[0] == '0') {
+        base = 8;
+        start = 1;
+    }
+    uint64_t value = 0;
+    for (size_t i = start; i < digits.size(); i++) {
+        char c = digits[i];
+        unsigned digit = c >= '0' && c <= '9' ? c - '0'
+                       : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                       : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+        if (digit >= static_cast<unsigned>(base)) {
+            break;
+        }
+        value = value * base + digit;
+    }
+    return static_cast<int64_t>(negative ? 0 - value : value);
+}
+
+} // namespace
+
+bool ASTNode::fieldAttribute(std::string_view key, std::string& value) const {
+    if (key == "field" && field != NO_SYMBOL) {
+        value = getFieldText();
+    } else if (key == "fixity" && postfix) {
+        value = "postfix";
+    } else if (key == "literalType" && literalKind != NO_LITERAL) {
+        value = literalKindName(literalKind);
+    } else if (key == "name" && name != NO_SYMBOL) {
+        value = getNameText();
+    } else if (key == "operator" && op != TK_NONE) {
+        value = kindText(op);
+    } else if (key == (type == METHOD_DECL ? "returnType" : "type") && typeName != NO_SYMBOL) {
+        value = getTypeNameText();
+    } else if (key == "value" && literalKind != NO_LITERAL && !literalText.empty()) {
+        value = literalText;
+    } else {
+        return false;
     }
-    std::cout << toString() << (": " + attrs) << "\n";
+    return true;
+}
 
-    for (size_t i = 0; i < children.size(); ++i) {
-        children[i]->print(prefix + (isLast ? "    " : "│   "), i == children.size() - 1);
+std::vector<std::pair<std::string_view, std::string>> ASTNode::attributeList() const {
+    std::vector<std::pair<std::string_view, std::string>> list;
+    if (field != NO_SYMBOL) {
+        list.emplace_back("field", std::string(getFieldText()));
     }
+    if (postfix) {
+        list.emplace_back("fixity", "postfix");
+    }
+    if (literalKind != NO_LITERAL) {
+        list.emplace_back("literalType", literalKindName(literalKind));
+    }
+    if (name != NO_SYMBOL) {
+        list.emplace_back("name", std::string(getNameText()));
+    }
+    if (op != TK_NONE) {
+        list.emplace_back("operator", std::string(kindText(op)));
+    }
+    if (typeName != NO_SYMBOL) {
+        list.emplace_back(type == METHOD_DECL ? "returnType" : "type", std::string(getTypeNameText()));
+    }
+    if (literalKind != NO_LITERAL && !literalText.empty()) {
+        list.emplace_back("value", std::string(literalText));
+    }
+    for (uint32_t i = 0; i < attributeCount; i++) {
+        list.emplace_back(attributes[i].key, std::string(attributes[i].value));
+    }
+    std::stable_sort(list.begin(), list.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    return list;
 }
 
-void ASTNode::setAttribute(const std::string& key, const std::string& value) {
-    attributes[key] = value;
+void ASTNode::setAttribute(const std::string& key, std::string_view value) {
+    Attribute* end = attributes + attributeCount;
+    Attribute* it = std::lower_bound(attributes, end, key,
+        [](const Attribute& attribute, const std::string& key) { return attribute.key < key; });
+    if (it != end && it->key == key) {
+        it->value = arena->copy(value);
+        return;
+    }
+    size_t position = it - attributes;
+    if (attributeCount == attributeCapacity) {
+        uint32_t grown = attributeCapacity == 0 ? 2 : attributeCapacity * 2;
+        Attribute* moved = arena->allocateArray<Attribute>(grown);
+        std::copy(attributes, attributes + attributeCount, moved);
+        attributes = moved;
+        attributeCapacity = grown;
+    }
+    std::copy_backward(attributes + position, attributes + attributeCount,
+                       attributes + attributeCount + 1);
+    attributes[position] = Attribute{arena->copy(key), arena->copy(value)};
+    attributeCount++;
 }
 
+// Сначала свои атрибуты (они упорядочены по ключу), затем поля узла
 std::string ASTNode::getAttribute(const std::string& key) const {
-    auto it = attributes.find(key);
-    if (it != attributes.end()) {
-        return it->second;
+    Attribute* end = attributes + attributeCount;
+    Attribute* it = std::lower_bound(attributes, end, key,
+        [](const Attribute& attribute, const std::string& key) { return attribute.key < key; });
+    if (it != end && it->key == key) {
+        return std::string(it->value);
     }
-    return "";
+    std::string value;
+    fieldAttribute(key, value);
+    return value;
+}
+
+void ASTNode::setName(SymbolId id) { name = id; }
+SymbolId ASTNode::getName() const { return name; }
+
+std::string_view ASTNode::getNameText() const {
+    return name == NO_SYMBOL ? std::string_view() : Interner::global().name(name);
 }
 
-std::string ASTNode::toString(){
+void ASTNode::setField(SymbolId id) { field = id; }
+SymbolId ASTNode::getField() const { return field; }
+
+std::string_view ASTNode::getFieldText() const {
+    return field == NO_SYMBOL ? std::string_view() : Interner::global().name(field);
+}
+
+void ASTNode::setTypeName(SymbolId id) { typeName = id; }
+
+SymbolId ASTNode::getTypeName() const { return typeName; }
+
+std::string_view ASTNode::getTypeNameText() const {
+    return typeName == NO_SYMBOL ? std::string_view() : Interner::global().name(typeName);
+}
+
+void ASTNode::setOperator(TokenKind kind, bool isPostfix) {
+    op = kind;
+    postfix = isPostfix;
+}
+
+void ASTNode::setResolvedType(TypeId id) { resolvedType = id; }
+TypeId ASTNode::getResolvedType() const { return resolvedType; }
+
+TokenKind ASTNode::getOperator() const { return op; }
+std::string_view ASTNode::getOperatorText() const { return kindText(op); }
+bool ASTNode::isPostfix() const { return postfix; }
+
+void ASTNode::setLiteral(LiteralKind kind, std::string_view text) {
+    literalKind = kind;
+    literalText = arena->copy(text);
+    switch (kind) {
+        case INT_LITERAL:
+            literal.intValue = parseIntLiteral(text);
+            break;
+        case FLOAT_LITERAL:
+            literal.floatValue = std::strtod(std::string(text).c_str(), nullptr);
+            break;
+        case CHAR_LITERAL:
+            literal.intValue = parseCharLiteral(text);
+            break;
+        case BOOLEAN_LITERAL:
+            literal.boolValue = text == "true";
+            break;
+        default:
+            literal.intValue = 0;
+            break;
+    }
+}
+
+ASTNode::LiteralKind ASTNode::getLiteralKind() const { return literalKind; }
+std::string_view ASTNode::getLiteralText() const { return literalText; }
+int64_t ASTNode::getIntValue() const { return literal.intValue; }
+double ASTNode::getFloatValue() const { return literal.floatValue; }
+bool ASTNode::getBoolValue() const { return literal.boolValue; }
+
+std::string ASTNode::toString() const {
     switch (type) {
         case PROGRAM: return "PROGRAM";
         case CLASS_DECL: return "CLASS_DECL";
@@ -350,6 +872,7 @@ std::string ASTNode::toString(){
         case FIELD_ACCESS: return "FIELD_ACCESS";
         case NEW_EXPR: return "NEW_EXPR";
         case ASSIGNMENT: return "ASSIGNMENT";
+        case CONDITIONAL_EXPR: return "CONDITIONAL_EXPR";
         default: return "UNKNOWN";
     }
 }
@@ -357,21 +880,21 @@ std::string ASTNode::toString(){
 
 // SemanticAnalyzer
 
-SemanticAnalyzer::SemanticAnalyzer() {
+SemanticAnalyzer::SemanticAnalyzer() : currentClass(nullptr), currentMethod(nullptr) {
     globalScope = std::make_unique<SymbolTable>();
     currentScope = globalScope.get();
     initializeBuiltins();
 }
 
 SemanticAnalyzer::~SemanticAnalyzer() {
-    while (!scopes.empty()) {
-        scopes.pop_back();
+    while (localScopes.depth() > 0) {
+        localScopes.exitScope();
     }
 }
 
 void SemanticAnalyzer::analyze(ASTNode* ast) {
     try {
-        visitNode(ast);
+        run(VISIT, ast);
         std::cout << "Semantic analysis completed successfully." << std::endl;
     } catch (const SemanticError& error) {
         errors.push_back(error);
@@ -380,6 +903,227 @@ void SemanticAnalyzer::analyze(ASTNode* ast) {
     }
 }
 
+void SemanticAnalyzer::run(TaskKind kind, ASTNode* node) {
+    tasks.clear();
+    pending.clear();
+    types.clear();
+    tasks.push_back(Task{kind, node, 0, nullptr});
+    while (!tasks.empty()) {
+        Task task = tasks.back();
+        tasks.pop_back();
+        perform(task);
+        tasks.insert(tasks.end(), pending.rbegin(), pending.rend());
+        pending.clear();
+    }
+}
+
+void SemanticAnalyzer::schedule(TaskKind kind, ASTNode* node, size_t index, Symbol* saved) {
+    pending.push_back(Task{kind, node, index, saved});
+}
+
+Type SemanticAnalyzer::popType() {
+    Type type = types.back();
+    types.pop_back();
+    return type;
+}
+
+void SemanticAnalyzer::perform(const Task& task) {
+    ASTNode* node = task.node;
+    switch (task.kind) {
+        case VISIT:
+            visitNode(node);
+            break;
+        case CHECK:
+            checkExpression(node);
+            break;
+        case ASSIGNMENT_TARGET:
+            checkAssignmentTarget(node);
+            break;
+        case DISCARD:
+            types.pop_back();
+            break;
+        case ENTER_SCOPE:
+            enterScope();
+            break;
+        case EXIT_SCOPE:
+            exitScope();
+            break;
+        case ENTER_LOOP:
+            contextStack.push(LOOP_CONTEXT);
+            break;
+        case LEAVE_CONTEXT:
+            contextStack.pop();
+            break;
+        case CLASS_END:
+            currentClass = static_cast<ClassSymbol*>(task.saved);
+            currentScope = currentClass ? currentClass->getSymbolTable() : globalScope.get();
+            break;
+        case METHOD_END:
+            finishMethodDeclaration(node, static_cast<FunctionSymbol*>(task.saved));
+            break;
+        case FIELD_INIT: {
+            Type initType = popType();
+            Type fieldType = Type::fromId(node->getResolvedType());
+            if (!initType.isAssignableTo(fieldType)) {
+                throw SemanticError("Cannot assign " + initType.toString() + 
+                                 " to field of type " + fieldType.toString(), 
+                                 node->getChild(0)->getLoc());
+            }
+            break;
+        }
+        case VARIABLE_INIT:
+            finishVariableDeclaration(node);
+            break;
+        case ARRAY_ELEMENT: {
+            Type elementExprType = popType();
+            Type elementType = Type::fromId(node->getResolvedType()).getElementType();
+            // elementExprType.primitiveKind
+            if (!elementExprType.getElementType().isAssignableTo(elementType)) {
+                throw SemanticError("Array element type mismatch. Expected " +
+                                  elementType.toString() + ", got " +
+                                  elementExprType.toString(),
+                                  node->getChild(task.index)->getLoc());
+            }
+            break;
+        }
+        case CONDITION: {
+            Type condType = popType();
+            if (!condType.isBoolean()) {
+                const char* statement = node->getType() == ASTNode::IF_STMT ? "If"
+                                      : node->getType() == ASTNode::FOR_STMT ? "For" : "While";
+                throw SemanticError(std::string(statement) + " condition must be boolean, found " + condType.toString(), 
+                                 node->getChild(task.index)->getLoc());
+            }
+            break;
+        }
+        case SWITCH_BEGIN:
+            beginSwitchCases(node);
+            break;
+        case SWITCH_CASE:
+            finishSwitchCase(node, task.index);
+            break;
+        case SWITCH_DEFAULT:
+            if (switchLabels.back().hasDefault) {
+                throw SemanticError("Multiple default cases", node->getChild(task.index)->getLoc());
+            }
+            switchLabels.back().hasDefault = true;
+            break;
+        case SWITCH_END:
+            switchConditionStack.pop_back();
+            switchLabels.pop_back();
+            contextStack.pop();
+            break;
+        case CASE_VALUE: {
+            Type switchType = switchConditionStack.back();
+            Type caseType = popType();
+            if (!caseType.isAssignableTo(switchType)) {
+                throw SemanticError(
+                    "Case type " + caseType.toString() + 
+                    " is incompatible with switch type " + switchType.toString(),
+                    node->getLoc()
+                );
+            }
+            break;
+        }
+        case RETURN_VALUE:
+            finishReturnStatement(node);
+            break;
+        case ASSIGNMENT_END: {
+            Type rhsType = popType();
+            Type lhsType = popType();
+            if (!rhsType.isAssignableTo(lhsType)) {
+                throw SemanticError("Cannot assign " + rhsType.toString() + 
+                                 " to variable of type " + lhsType.toString(), 
+                                 node->getLoc());
+            }
+            break;
+        }
+        case TARGET_ARRAY: {
+            Type indexType = popType();
+            Type arrayType = popType();
+            types.push_back(arrayTargetType(node, arrayType, indexType));
+            break;
+        }
+        case TARGET_FIELD: {
+            Type objectType = popType();
+            types.push_back(fieldTargetType(node, objectType));
+            break;
+        }
+        case ARRAY_INIT_ELEMENT: {
+            Type currentType = popType();
+            if (!currentType.isAssignableTo(types.back())) {
+                throw SemanticError("Inconsistent array element types", node->getLoc());
+            }
+            break;
+        }
+        case ARRAY_INIT_END:
+            types.back() = Type::arrayType(types.back(), 1);
+            break;
+        case BINARY: {
+            Type rightType = popType();
+            Type leftType = popType();
+            types.push_back(binaryExpressionType(node, leftType, rightType));
+            break;
+        }
+        case UNARY: {
+            Type exprType = popType();
+            types.push_back(unaryExpressionType(node, exprType));
+            break;
+        }
+        case TERNARY_CONDITION:
+            if (!popType().isBoolean()) {
+                throw SemanticError("Condition of ?: must be boolean", node->getChild(0)->getLoc());
+            }
+            break;
+        case TERNARY: {
+            Type elseType = popType();
+            Type thenType = popType();
+            types.push_back(conditionalExpressionType(node, thenType, elseType));
+            break;
+        }
+        case OBJECT_CALL:
+            checkObjectMethodCall(node);
+            break;
+        case CALL_ARGUMENT: {
+            // Под типом аргумента лежит ожидаемый тип параметра
+            Type argType = popType();
+            Type resolvedParam = popType();
+            if (!argType.isAssignableTo(resolvedParam)) {
+                throw SemanticError("Parameter type mismatch: expected " + resolvedParam.toString() + 
+                                  ", got " + argType.toString(), node->getChild(task.index)->getLoc());
+            }
+            break;
+        }
+        case CALL:
+            finishMethodCall(node);
+            break;
+        case ARRAY_ACCESS_ARRAY:
+            if (!types.back().isArray()) {
+                throw SemanticError("Array access on non-array type", node->getLoc());
+            }
+            break;
+        case ARRAY_ACCESS_INDEX:
+            if (!popType().isInt()) {
+                throw SemanticError("Array index must be numeric", node->getChild(1)->getLoc());
+            }
+            types.back() = types.back().getElementType();
+            break;
+        case FIELD: {
+            Type objectType = popType();
+            types.push_back(fieldAccessType(node, objectType));
+            break;
+        }
+        case NEW_ARRAY: {
+            Type sizeType = popType();
+            if (!sizeType.isInt()) {
+                throw SemanticError("Array size must be int, found: " + sizeType.toString(), 
+                                 node->getChild(0)->getLoc());
+            }
+            types.push_back(Type::arrayType(resolveNodeType(node)));
+            break;
+        }
+    }
+}
 bool SemanticAnalyzer::hasErrors() const {
     return !errors.empty();
 }
@@ -389,15 +1133,15 @@ const std::vector<SemanticError>& SemanticAnalyzer::getErrors() const {
 }
 
 void SemanticAnalyzer::initializeBuiltins() {
-    currentScope->define(new Symbol("boolean", Type::booleanType(), Symbol::CLASS));
-    currentScope->define(new Symbol("char", Type::charType(), Symbol::CLASS));
-    currentScope->define(new Symbol("int", Type::intType(), Symbol::CLASS));
-    currentScope->define(new Symbol("float", Type::floatType(), Symbol::CLASS));
-    currentScope->define(new Symbol("double", Type::doubleType(), Symbol::CLASS));
-    currentScope->define(new Symbol("void", Type::voidType(), Symbol::CLASS));
-    currentScope->define(new Symbol("String", Type::stringType(), Symbol::CLASS));
+    declare(new Symbol("boolean", Type::booleanType(), Symbol::CLASS));
+    declare(new Symbol("char", Type::charType(), Symbol::CLASS));
+    declare(new Symbol("int", Type::intType(), Symbol::CLASS));
+    declare(new Symbol("float", Type::floatType(), Symbol::CLASS));
+    declare(new Symbol("double", Type::doubleType(), Symbol::CLASS));
+    declare(new Symbol("void", Type::voidType(), Symbol::CLASS));
+    declare(new Symbol("String", Type::stringType(), Symbol::CLASS));
     // currentScope->define(new Symbol("Integer", Type::classType("Integer"), Symbol::CLASS));
-    currentScope->define(new Symbol("Integer", Type::intType(), Symbol::CLASS));
+    declare(new Symbol("Integer", Type::intType(), Symbol::CLASS));
 
     auto printlnMethod = new FunctionSymbol("println", Type::voidType());
     printlnMethod->addParameter("value", Type::stringType());
@@ -447,20 +1191,49 @@ void SemanticAnalyzer::initializeBuiltins() {
     globalScope->define(arrayListClass);
     globalScope->define(hashMapClass);
     globalScope->define(integerClass);
-    currentScope->define(systemClass);
-    currentScope->define(printStreamClass);
+    declare(systemClass);
+    declare(printStreamClass);
 }
 
+// currentScope не меняется, пока открыты области тела метода. После
+// закрытия последней из них поиск, как и раньше, идёт в глобальных именах
 void SemanticAnalyzer::enterScope() {
-    scopes.push_back(std::make_unique<SymbolTable>(currentScope));
-    currentScope = scopes.back().get();
+    localScopes.enterScope();
 }
 
 void SemanticAnalyzer::exitScope() {
-    if (!scopes.empty()) {
-        scopes.pop_back();
-        currentScope = scopes.empty() ? globalScope.get() : scopes.back().get();
+    if (localScopes.depth() > 0) {
+        localScopes.exitScope();
+        if (localScopes.depth() == 0) {
+            currentScope = globalScope.get();
+        }
+    }
+}
+
+void SemanticAnalyzer::declare(Symbol* symbol) {
+    if (localScopes.depth() > 0) {
+        localScopes.define(symbol);
+    } else {
+        currentScope->define(symbol);
+    }
+}
+
+Symbol* SemanticAnalyzer::lookup(SymbolId id) const {
+    if (localScopes.depth() > 0) {
+        if (Symbol* symbol = localScopes.resolve(id)) {
+            return symbol;
+        }
     }
+    return currentScope->resolve(id);
+}
+
+Symbol* SemanticAnalyzer::lookup(const std::string& name) const {
+    SymbolId id = Interner::global().find(name);
+    return id == NO_SYMBOL ? nullptr : lookup(id);
+}
+
+Symbol* SemanticAnalyzer::lookupLocally(SymbolId id) const {
+    return localScopes.depth() > 0 ? localScopes.resolveLocally(id) : currentScope->resolveLocally(id);
 }
 
 std::vector<std::string> split(const std::string& s, char delimiter) {
@@ -473,7 +1246,7 @@ std::vector<std::string> split(const std::string& s, char delimiter) {
     return tokens;
 }
 
-Type SemanticAnalyzer::resolveType(const std::string& typeName, int line) {
+Type SemanticAnalyzer::resolveType(const std::string& typeName, SourceLoc loc) {
     static const std::map<std::string, std::string> primitiveToWrapper = {
         {"int", "Integer"},
         {"boolean", "Boolean"}
@@ -489,7 +1262,7 @@ Type SemanticAnalyzer::resolveType(const std::string& typeName, int line) {
     size_t arrayBracketPos = typeName.find("[]");
     if (arrayBracketPos != std::string::npos) {
         std::string baseTypeName = typeName.substr(0, arrayBracketPos);
-        Type baseType = resolveType(baseTypeName, line);
+        Type baseType = resolveType(baseTypeName, loc);
         
         int dimensions = 0;
         std::string arrayPart = typeName.substr(arrayBracketPos);
@@ -505,7 +1278,7 @@ Type SemanticAnalyzer::resolveType(const std::string& typeName, int line) {
     size_t anglePos = typeName.find('<');
     if (anglePos != std::string::npos) {
         std::string baseName = typeName.substr(0, anglePos);
-        Type baseType = resolveType(baseName, line);
+        Type baseType = resolveType(baseName, loc);
         
         // Извлекаем аргументы типа
         std::vector<Type> typeArgs;
@@ -515,7 +1288,7 @@ Type SemanticAnalyzer::resolveType(const std::string& typeName, int line) {
         std::vector<std::string> argStrings = split(argsStr, ',');
         
         for (const auto& arg : argStrings) {
-            typeArgs.push_back(resolveType(arg, line));
+            typeArgs.push_back(resolveType(arg, loc));
         }
         
         return Type::genericType(baseType, typeArgs);
@@ -533,14 +1306,14 @@ Type SemanticAnalyzer::resolveType(const std::string& typeName, int line) {
     // Symbol* symbol = currentScope->resolve(typeName);
     Symbol* symbol = globalScope->resolve(typeName);
     if (!symbol) {
-        throw SemanticError("Unknown type: " + typeName, line);
+        throw SemanticError("Unknown type: " + typeName, loc);
     }
     
     if (symbol->isClass()) {
         ClassSymbol* classSymbol = dynamic_cast<ClassSymbol*>(symbol);
         if (classSymbol && classSymbol->isGenericClass()) {
             // Логика для обработки generic-классов
-            return Type::genericType(Type::classType(classSymbol->getName()), 
+            return Type::genericType(Type::classType(std::string(classSymbol->getName())), 
                 {} // Заполнить реальными параметрами при конкретизации
             );
         }
@@ -557,6 +1330,15 @@ Type SemanticAnalyzer::resolveType(const std::string& typeName, int line) {
     return Type::classType(typeName);
 }
 
+// Строка typeName разбирается один раз, дальше узел отдаёт готовый TypeId
+Type SemanticAnalyzer::resolveNodeType(ASTNode* node) {
+    if (node->getResolvedType() == NO_TYPE) {
+        Type type = resolveType(std::string(node->getTypeNameText()), node->getLoc());
+        node->setResolvedType(type.getId());
+    }
+    return Type::fromId(node->getResolvedType());
+}
+
 void SemanticAnalyzer::visitNode(ASTNode* ASTNode) {
     if (!ASTNode) return;
 
@@ -614,7 +1396,8 @@ void SemanticAnalyzer::visitNode(ASTNode* ASTNode) {
             break;
         default:
             if (ASTNode->getType() >= ASTNode::BINARY_EXPR) {
-                checkExpression(ASTNode);
+                schedule(CHECK, ASTNode);
+                schedule(DISCARD, ASTNode);
             }
             break;
     }
@@ -622,19 +1405,18 @@ void SemanticAnalyzer::visitNode(ASTNode* ASTNode) {
 
 void SemanticAnalyzer::visitProgram(ASTNode* ASTNode) {
     for (size_t i = 0; i < ASTNode->getChildCount(); i++) {
-        visitNode(ASTNode->getChild(i));
+        schedule(VISIT, ASTNode->getChild(i));
     }
 }
-
 void SemanticAnalyzer::visitClassDeclaration(ASTNode* ASTNode) {
-    std::string className = ASTNode->getAttribute("name");
+    std::string className(ASTNode->getNameText());
     
-    if (currentScope->resolveLocally(className)) {
-        throw SemanticError("Class " + className + " is already defined", ASTNode->getLine());
+    if (lookupLocally(ASTNode->getName())) {
+        throw SemanticError("Class " + className + " is already defined", ASTNode->getLoc());
     }
     
     ClassSymbol* classSymbol = new ClassSymbol(className);
-    currentScope->define(classSymbol);
+    declare(classSymbol);
     
     ClassSymbol* outerClass = currentClass;
     currentClass = classSymbol;
@@ -642,29 +1424,26 @@ void SemanticAnalyzer::visitClassDeclaration(ASTNode* ASTNode) {
     currentScope = classSymbol->getSymbolTable();
     
     for (size_t i = 0; i < ASTNode->getChildCount(); i++) {
-        visitNode(ASTNode->getChild(i));
+        schedule(VISIT, ASTNode->getChild(i));
     }
     
-    currentClass = outerClass;
-    currentScope = currentClass ? currentClass->getSymbolTable() : globalScope.get();
+    schedule(CLASS_END, ASTNode, 0, outerClass);
 }
 
 
 
 void SemanticAnalyzer::visitMethodDeclaration(ASTNode* Node) {
-    if (Node->getAttribute("genericParams") != "") {
-        std::string paramsStr = Node->getAttribute("genericParams");
+    std::string paramsStr = Node->getAttribute("genericParams");
+    if (!paramsStr.empty()) {
         // Парсим параметры типа через запятую
         std::vector<std::string> genericParams = split(paramsStr, ',');
         
         for (const auto& param : genericParams) {
-            currentScope->define(new Symbol(param, Type::genericParamType(param), Symbol::TYPE_PARAM));
+            declare(new Symbol(param, Type::genericParamType(param), Symbol::TYPE_PARAM));
         }
     }
-    std::string methodName = Node->getAttribute("name");
-    std::string returnTypeName = Node->getAttribute("returnType");
-    
-    Type returnType = resolveType(returnTypeName, Node->getLine());
+    std::string methodName(Node->getNameText());
+    Type returnType = resolveNodeType(Node);
     
     FunctionSymbol* methodSymbol = new FunctionSymbol(methodName, returnType);
     
@@ -675,7 +1454,7 @@ void SemanticAnalyzer::visitMethodDeclaration(ASTNode* Node) {
         ASTNode* child = Node->getChild(i);
         if (child->getType() == ASTNode::BLOCK) {
             bodyNode = child;
-        } else if (child->getAttribute("type") == "parameters") {
+        } else if (child->getType() == ASTNode::PARAMETER_LIST) {
             paramsNode = child;
         }
     }
@@ -683,11 +1462,8 @@ void SemanticAnalyzer::visitMethodDeclaration(ASTNode* Node) {
     if (paramsNode) {
         for (size_t i = 0; i < paramsNode->getChildCount(); i++) {
             ASTNode* paramNode = paramsNode->getChild(i);
-            std::string paramName = paramNode->getAttribute("name");
-            std::string paramTypeName = paramNode->getAttribute("type");
-            
-            Type paramType = resolveType(paramTypeName, paramNode->getLine());
-            methodSymbol->addParameter(paramName, paramType);
+            Type paramType = resolveNodeType(paramNode);
+            methodSymbol->addParameter(std::string(paramNode->getNameText()), paramType);
         }
     }
     
@@ -695,26 +1471,32 @@ void SemanticAnalyzer::visitMethodDeclaration(ASTNode* Node) {
     FunctionSymbol* outerMethod = currentMethod;
     currentMethod = methodSymbol;
     
-    currentScope->define(methodSymbol);
+    declare(methodSymbol);
     enterScope();
     
     if (paramsNode) {
         for (size_t i = 0; i < paramsNode->getChildCount(); i++) {
             ASTNode* paramNode = paramsNode->getChild(i);
-            std::string paramName = paramNode->getAttribute("name");
-            std::string paramTypeName = paramNode->getAttribute("type");
-            
-            Type paramType = resolveType(paramTypeName, paramNode->getLine());
-            currentScope->define(new Symbol(paramName, paramType, Symbol::VARIABLE));
+            declare(new Symbol(paramNode->getName(), methodSymbol->getParameterType(i), Symbol::VARIABLE));
         }
     }
     
     if (bodyNode) {
-        visitNode(bodyNode);
+        schedule(VISIT, bodyNode);
+    }
+    schedule(METHOD_END, Node, 0, outerMethod);
+}
+
+void SemanticAnalyzer::finishMethodDeclaration(ASTNode* Node, FunctionSymbol* outerMethod) {
+    ASTNode* bodyNode = nullptr;
+    for (size_t i = 0; i < Node->getChildCount(); i++) {
+        if (Node->getChild(i)->getType() == ASTNode::BLOCK) {
+            bodyNode = Node->getChild(i);
+        }
     }
     
-    if (!returnType.isVoid() && !hasReturnStatement(bodyNode)) {
-        throw SemanticError("Missing return statement in method " + methodName, Node->getLine());
+    if (!currentMethod->getType().isVoid() && !hasReturnStatement(bodyNode)) {
+        throw SemanticError("Missing return statement in method " + std::string(Node->getNameText()), Node->getLoc());
     }
     
     exitScope();
@@ -722,81 +1504,66 @@ void SemanticAnalyzer::visitMethodDeclaration(ASTNode* Node) {
 }
 
 void SemanticAnalyzer::visitFieldDeclaration(ASTNode* Node) {
-    std::string fieldName = Node->getAttribute("name");
-    std::string typeName = Node->getAttribute("type");
+    Type fieldType = resolveNodeType(Node);
     
-    Type fieldType = resolveType(typeName, Node->getLine());
-    
-    if (currentScope->resolveLocally(fieldName)) {
-        throw SemanticError("Field " + fieldName + " is already defined in this class", Node->getLine());
+    if (lookupLocally(Node->getName())) {
+        throw SemanticError("Field " + std::string(Node->getNameText()) + " is already defined in this class", Node->getLoc());
     }
     
-    currentScope->define(new Symbol(fieldName, fieldType, Symbol::VARIABLE));
+    declare(new Symbol(Node->getName(), fieldType, Symbol::VARIABLE));
     
     if (Node->getChildCount() > 0) {
-        ASTNode* initASTNode = Node->getChild(0);
-        Type initType = checkExpression(initASTNode);
-        
-        if (!initType.isAssignableTo(fieldType)) {
-            throw SemanticError("Cannot assign " + initType.toString() + 
-                             " to field of type " + fieldType.toString(), 
-                             initASTNode->getLine());
-        }
+        schedule(CHECK, Node->getChild(0));
+        schedule(FIELD_INIT, Node);
     }
 }
 
 void SemanticAnalyzer::visitVariableDeclaration(ASTNode* Node) {
-    std::string varName = Node->getAttribute("name");
-    std::string typeName = Node->getAttribute("type");
+    Type varType = resolveNodeType(Node);
     
-    Type varType = resolveType(typeName, Node->getLine());
-    
-    if (currentScope->resolveLocally(varName)) {
-        throw SemanticError("Variable " + varName + " is already defined in this scope", Node->getLine());
+    if (lookupLocally(Node->getName())) {
+        throw SemanticError("Variable " + std::string(Node->getNameText()) + " is already defined in this scope", Node->getLoc());
     }
     
-    currentScope->define(new Symbol(varName, varType, Symbol::VARIABLE));
+    declare(new Symbol(Node->getName(), varType, Symbol::VARIABLE));
     
     if (Node->getChildCount() > 0) {
         if (varType.isArray()) {
-            visitArrayInitialization(Node, varType);
+            visitArrayInitialization(Node);
         } 
         else { // Обычная переменная
-            ASTNode* initNode = Node->getChild(0);
-            Type initType = checkExpression(initNode);
-            
-            // Для массивов учитываем ковариантность
-            if (varType.isArray() && initType.isArray()) {
-                if (!initType.getElementType().isAssignableTo(varType.getElementType())) {
-                    // throwTypeMismatchError(varType, initType, initNode);
-                    throw SemanticError("Cannot assign " + initType.toString() + 
-                             " to variable of type " + varType.toString(), 
-                             initNode->getLine());
-                }
-            }
-            if (!initType.isAssignableTo(varType)) {
-                throw SemanticError("Cannot assign " + initType.toString() + 
-                             " to variable of type " + varType.toString(), 
-                             initNode->getLine());
-            }
+            schedule(CHECK, Node->getChild(0));
+            schedule(VARIABLE_INIT, Node);
         }
     }
 }
 
-void SemanticAnalyzer::visitArrayInitialization(ASTNode* varNode, const Type& arrayType) {
-    Type elementType = arrayType.getElementType();
+void SemanticAnalyzer::finishVariableDeclaration(ASTNode* Node) {
+    ASTNode* initNode = Node->getChild(0);
+    Type initType = popType();
+    Type varType = Type::fromId(Node->getResolvedType());
     
+    // Для массивов учитываем ковариантность
+    if (varType.isArray() && initType.isArray()) {
+        if (!initType.getElementType().isAssignableTo(varType.getElementType())) {
+            // throwTypeMismatchError(varType, initType, initNode);
+            throw SemanticError("Cannot assign " + initType.toString() + 
+                     " to variable of type " + varType.toString(), 
+                     initNode->getLoc());
+        }
+    }
+    if (!initType.isAssignableTo(varType)) {
+        throw SemanticError("Cannot assign " + initType.toString() + 
+                     " to variable of type " + varType.toString(), 
+                     initNode->getLoc());
+    }
+}
+
+void SemanticAnalyzer::visitArrayInitialization(ASTNode* varNode) {
     // Проверяем все элементы инициализации
     for (size_t i = 0; i < varNode->getChildCount(); i++) {
-        ASTNode* elementNode = varNode->getChild(i);
-        Type elementExprType = checkExpression(elementNode);
-        // elementExprType.primitiveKind
-        if (!elementExprType.getElementType().isAssignableTo(elementType)) {
-            throw SemanticError("Array element type mismatch. Expected " +
-                              elementType.toString() + ", got " +
-                              elementExprType.toString(),
-                              elementNode->getLine());
-        }
+        schedule(CHECK, varNode->getChild(i));
+        schedule(ARRAY_ELEMENT, varNode, i);
     }
     
     // Дополнительная проверка для явного создания массива
@@ -820,147 +1587,120 @@ void SemanticAnalyzer::visitBlock(ASTNode* Node) {
     enterScope();
     
     for (size_t i = 0; i < Node->getChildCount(); i++) {
-        visitNode(Node->getChild(i));
+        schedule(VISIT, Node->getChild(i));
     }
     
-    exitScope();
+    schedule(EXIT_SCOPE, Node);
 }
-
 void SemanticAnalyzer::visitIfStatement(ASTNode* Node) {
-    ASTNode* conditionASTNode = Node->getChild(0);
-    Type condType = checkExpression(conditionASTNode);
+    schedule(CHECK, Node->getChild(0));
+    schedule(CONDITION, Node, 0);
     
-    if (!condType.isBoolean()) {
-        throw SemanticError("If condition must be boolean, found " + condType.toString(), 
-                         conditionASTNode->getLine());
-    }
-    
-    visitNode(Node->getChild(1));
+    schedule(VISIT, Node->getChild(1));
     
     if (Node->getChildCount() > 2) {
-        visitNode(Node->getChild(2));
+        schedule(VISIT, Node->getChild(2));
     }
 }
-
 void SemanticAnalyzer::visitWhileStatement(ASTNode* Node) {
-    ASTNode* conditionNode = Node->getChild(0);
-    Type condType = checkExpression(conditionNode);
-    contextStack.push(LOOP_CONTEXT);
-    if (!condType.isBoolean()) {
-        throw SemanticError("While condition must be boolean, found " + condType.toString(), 
-                         conditionNode->getLine());
-    }
-    
-    visitNode(Node->getChild(1));
-    contextStack.pop();
+    schedule(CHECK, Node->getChild(0));
+    schedule(CONDITION, Node, 0);
+    schedule(ENTER_LOOP, Node);
+    schedule(VISIT, Node->getChild(1));
+    schedule(LEAVE_CONTEXT, Node);
 }
-
 void SemanticAnalyzer::visitDoWhileStatement(ASTNode* Node) {
-    ASTNode* conditionNode = Node->getChild(1);
-    Type condType = checkExpression(conditionNode);
-    contextStack.push(LOOP_CONTEXT);
-    
-    if (!condType.isBoolean()) {
-        throw SemanticError("While condition must be boolean, found " + condType.toString(), 
-                         conditionNode->getLine());
-    }
-    
-    visitNode(Node->getChild(0));
-    contextStack.pop();
+    schedule(CHECK, Node->getChild(1));
+    schedule(CONDITION, Node, 1);
+    schedule(ENTER_LOOP, Node);
+    schedule(VISIT, Node->getChild(0));
+    schedule(LEAVE_CONTEXT, Node);
 }
-
 void SemanticAnalyzer::visitForStatement(ASTNode* Node) {
     enterScope();
     
     if (Node->getChildCount() > 0) {
-        visitNode(Node->getChild(0));
+        schedule(VISIT, Node->getChild(0));
     }
     
     if (Node->getChildCount() > 1) {
-        ASTNode* conditionASTNode = Node->getChild(1);
-        Type condType = checkExpression(conditionASTNode);
-        
-        if (!condType.isBoolean()) {
-            throw SemanticError("For condition must be boolean, found " + condType.toString(), 
-                             conditionASTNode->getLine());
-        }
+        schedule(CHECK, Node->getChild(1));
+        schedule(CONDITION, Node, 1);
     }
     
     if (Node->getChildCount() > 2) {
-        checkExpression(Node->getChild(2));
+        schedule(CHECK, Node->getChild(2));
+        schedule(DISCARD, Node);
     }
-    contextStack.push(LOOP_CONTEXT);
+    schedule(ENTER_LOOP, Node);
     
     if (Node->getChildCount() > 3) {
-        visitNode(Node->getChild(3));
+        schedule(VISIT, Node->getChild(3));
     }
-    contextStack.pop();
-    exitScope();
+    schedule(LEAVE_CONTEXT, Node);
+    schedule(EXIT_SCOPE, Node);
 }
-
 void SemanticAnalyzer::visitSwitchStatement(ASTNode* node) {
     // Проверка условия switch
-    ASTNode* condition = node->getChild(0);
-    Type condType = checkExpression(condition);
+    schedule(CHECK, node->getChild(0));
+    schedule(SWITCH_BEGIN, node);
+}
+
+void SemanticAnalyzer::beginSwitchCases(ASTNode* node) {
+    Type condType = popType();
     
     // Условие должно быть целочисленным или enum
     if (!condType.isInt() && !condType.isChar()) {
-        throw SemanticError("Switch condition must be integer or char", node->getLine());
+        throw SemanticError("Switch condition must be integer or char", node->getLoc());
     }
     
     // Проверка case-блоков
-    bool hasDefault = false;
-    std::set<std::string> caseValues;
     switchConditionStack.push_back(condType);
+    switchLabels.emplace_back();
     contextStack.push(SWITCH_CONTEXT);
 
     for (size_t i = 1; i < node->getChildCount(); i++) {
         ASTNode* child = node->getChild(i);
         if (child->getType() == ASTNode::CASE) {
-            visitCase(child);
-            
-            // Проверка уникальности значений
-            std::string value = child->getChild(0)->getAttribute("value");
-            if (caseValues.count(value)) {
-                throw SemanticError("Duplicate case value: " + value, child->getLine());
-            }
-            caseValues.insert(value);
+            schedule(VISIT, child);
+            schedule(SWITCH_CASE, node, i);
         }
         else if (child->getType() == ASTNode::DEFAULT) {
-            if (hasDefault) {
-                throw SemanticError("Multiple default cases", child->getLine());
-            }
-            hasDefault = true;
-            visitDefault(child);
+            schedule(SWITCH_DEFAULT, node, i);
+            schedule(VISIT, child);
         }
     }
-    switchConditionStack.pop_back();
-    contextStack.pop();
+    schedule(SWITCH_END, node);
 }
 
+// Проверка уникальности значений
+// Символ и число совпадают, если равны их коды: 'a' и 97
+void SemanticAnalyzer::finishSwitchCase(ASTNode* node, size_t index) {
+    ASTNode* child = node->getChild(index);
+    ASTNode* label = child->getChild(0);
+    std::string value(label->getLiteralText());
+    std::string key = label->getLiteralKind() == ASTNode::INT_LITERAL ||
+                      label->getLiteralKind() == ASTNode::CHAR_LITERAL
+        ? std::to_string(label->getIntValue()) : value;
+    std::set<std::string>& caseValues = switchLabels.back().values;
+    if (caseValues.count(key)) {
+        throw SemanticError("Duplicate case value: " + value, child->getLoc());
+    }
+    caseValues.insert(key);
+}
 void SemanticAnalyzer::visitCase(ASTNode* node) {
     if (switchConditionStack.empty()) {
-        throw SemanticError("Case outside switch statement", node->getLine());
+        throw SemanticError("Case outside switch statement", node->getLoc());
     }
-    Type switchType = switchConditionStack.back();
 
-    ASTNode* valueNode = node->getChild(0);
-    Type caseType = checkExpression(valueNode);
-    
-    if (!caseType.isAssignableTo(switchType)) {
-        throw SemanticError(
-            "Case type " + caseType.toString() + 
-            " is incompatible with switch type " + switchType.toString(),
-            node->getLine()
-        );
-    }
-    enterScope();
+    schedule(CHECK, node->getChild(0));
+    schedule(CASE_VALUE, node);
+    schedule(ENTER_SCOPE, node);
     for (size_t i = 1; i < node->getChildCount(); i++) {
-        visitNode(node->getChild(i));
+        schedule(VISIT, node->getChild(i));
     }
-    exitScope();
+    schedule(EXIT_SCOPE, node);
 }
-
 void SemanticAnalyzer::checkBreakValidity(ASTNode* node) {
     bool valid = false;
     std::stack<ContextType> temp = contextStack;
@@ -974,7 +1714,7 @@ void SemanticAnalyzer::checkBreakValidity(ASTNode* node) {
     }
     
     if (!valid) {
-        throw SemanticError("Break outside loop or switch", node->getLine());
+        throw SemanticError("Break outside loop or switch", node->getLoc());
     }
 }
 
@@ -991,215 +1731,215 @@ void SemanticAnalyzer::checkContinueValidity(ASTNode* node) {
     }
     
     if (!valid) {
-        throw SemanticError("Continue outside loop", node->getLine());
+        throw SemanticError("Continue outside loop", node->getLoc());
     }
 }
 
 void SemanticAnalyzer::visitDefault(ASTNode* node) {
     if (switchConditionStack.empty()) {
-        throw SemanticError("Default outside switch statement", node->getLine());
+        throw SemanticError("Default outside switch statement", node->getLoc());
     }
     enterScope();
     for (size_t i = 0; i < node->getChildCount(); i++) {
-        visitNode(node->getChild(i));
+        schedule(VISIT, node->getChild(i));
     }
-    exitScope();
+    schedule(EXIT_SCOPE, node);
 }
-
 void SemanticAnalyzer::visitReturnStatement(ASTNode* Node) {
     if (!currentMethod) {
-        throw SemanticError("Return statement outside of method", Node->getLine());
+        throw SemanticError("Return statement outside of method", Node->getLoc());
     }
     
-    Type methodReturnType = currentMethod->getType();
-    
     if (Node->getChildCount() > 0) {
-        ASTNode* exprASTNode = Node->getChild(0);
-        Type exprType = checkExpression(exprASTNode);
-        
-        if (methodReturnType.isVoid()) {
-            throw SemanticError("Cannot return a value from a void method", 
-                             exprASTNode->getLine());
-        }
-        
-        if (!exprType.isAssignableTo(methodReturnType)) {
-            throw SemanticError("Cannot return " + exprType.toString() + 
-                             " from method with return type " + methodReturnType.toString(), 
-                             exprASTNode->getLine());
-        }
+        schedule(CHECK, Node->getChild(0));
+        schedule(RETURN_VALUE, Node);
     } else {
+        Type methodReturnType = currentMethod->getType();
         if (!methodReturnType.isVoid()) {
             throw SemanticError("Missing return value in method with return type " + 
                              methodReturnType.toString(), 
-                             Node->getLine());
+                             Node->getLoc());
         }
     }
 }
 
+void SemanticAnalyzer::finishReturnStatement(ASTNode* Node) {
+    Type methodReturnType = currentMethod->getType();
+    ASTNode* exprASTNode = Node->getChild(0);
+    Type exprType = popType();
+    
+    if (methodReturnType.isVoid()) {
+        throw SemanticError("Cannot return a value from a void method", 
+                         exprASTNode->getLoc());
+    }
+    
+    if (!exprType.isAssignableTo(methodReturnType)) {
+        throw SemanticError("Cannot return " + exprType.toString() + 
+                         " from method with return type " + methodReturnType.toString(), 
+                         exprASTNode->getLoc());
+    }
+}
 void SemanticAnalyzer::visitExpressionStatement(ASTNode* Node) {
     if (Node->getChildCount() > 0) {
-        visitNode(Node->getChild(0));
+        schedule(VISIT, Node->getChild(0));
         // checkExpression(Node->getChild(0));
     }
 }
-
 void SemanticAnalyzer::visitAssignment(ASTNode* Node) {
-    ASTNode* lhsASTNode = Node->getChild(0);
-    ASTNode* rhsASTNode = Node->getChild(1);
-    
-    Type lhsType = checkAssignmentTarget(lhsASTNode);
-    Type rhsType = checkExpression(rhsASTNode);
-    
-    if (!rhsType.isAssignableTo(lhsType)) {
-        throw SemanticError("Cannot assign " + rhsType.toString() + 
-                         " to variable of type " + lhsType.toString(), 
-                         Node->getLine());
-    }
+    schedule(ASSIGNMENT_TARGET, Node->getChild(0));
+    schedule(CHECK, Node->getChild(1));
+    schedule(ASSIGNMENT_END, Node);
 }
-
-Type SemanticAnalyzer::checkAssignmentTarget(ASTNode* Node) {
+void SemanticAnalyzer::checkAssignmentTarget(ASTNode* Node) {
     ASTNode::NodeType type = Node->getType();
     
     if (type == ASTNode::VARIABLE) {
-        std::string varName = Node->getAttribute("name");
-        Symbol* symbol = currentScope->resolve(varName);
+        std::string varName(Node->getNameText());
+        Symbol* symbol = lookup(Node->getName());
         
         if (!symbol) {
             throw SemanticError("Undefined variable: " + varName, 
-                             Node->getLine());
+                             Node->getLoc());
         }
         
         if (!symbol->isVariable()) {
             throw SemanticError(varName + " is not a variable", 
-                             Node->getLine());
+                             Node->getLoc());
         }
         
-        return symbol->getType();
+        types.push_back(symbol->getType());
     } else if (type == ASTNode::ARRAY_ACCESS) {
-        ASTNode* arrayASTNode = Node->getChild(0);
-        ASTNode* indexASTNode = Node->getChild(1);
-        
-        Type arrayType = checkExpression(arrayASTNode);
-        Type indexType = checkExpression(indexASTNode);
-        
-        if (!arrayType.isArray()) {
-            throw SemanticError("Array access on non-array type: " + arrayType.toString(), 
-                             arrayASTNode->getLine());
-        }
-        
-        if (!indexType.isInt()) {
-            throw SemanticError("Array index must be numeric, found: " + indexType.toString(), 
-                             indexASTNode->getLine());
-        }
-        
-        return arrayType.getElementType();
+        schedule(CHECK, Node->getChild(0));
+        schedule(CHECK, Node->getChild(1));
+        schedule(TARGET_ARRAY, Node);
     } else if (type == ASTNode::FIELD_ACCESS) {
-        ASTNode* objectASTNode = Node->getChild(0);
-        std::string fieldName = Node->getAttribute("field");
-        
-        Type objectType = checkExpression(objectASTNode);
-        
-        if (!objectType.isClass()) {
-            throw SemanticError("Cannot access field on non-class type: " + objectType.toString(), 
-                             objectASTNode->getLine());
-        }
-        
-        std::string className = objectType.toString();
-        Symbol* classSymbol = currentScope->resolve(className);
-        
-        if (!classSymbol || !classSymbol->isClass()) {
-            throw SemanticError("Class not found: " + className, 
-                             Node->getLine());
-        }
-        
-        ClassSymbol* cls = static_cast<ClassSymbol*>(classSymbol);
-        Symbol* fieldSymbol = cls->getSymbolTable()->resolve(fieldName);
-        
-        if (!fieldSymbol) {
-            throw SemanticError("Field " + fieldName + " not found in class " + className, 
-                             Node->getLine());
-        }
-        
-        return fieldSymbol->getType();
+        schedule(CHECK, Node->getChild(0));
+        schedule(TARGET_FIELD, Node);
+    } else {
+        throw SemanticError("Invalid assignment target", Node->getLoc());
     }
-    
-    throw SemanticError("Invalid assignment target", Node->getLine());
 }
 
-Type SemanticAnalyzer::checkExpression(ASTNode* Node) {
-    switch (Node->getType()) {
-        case ASTNode::LITERAL: return checkLiteral(Node);
-        case ASTNode::VARIABLE: return checkVariable(Node);
-        case ASTNode::ARRAY_INIT: return checkArrayInitializer(Node);
-        case ASTNode::BINARY_EXPR: return checkBinaryExpression(Node);
-        case ASTNode::UNARY_EXPR: return checkUnaryExpression(Node);
-        case ASTNode::METHOD_CALL: return checkMethodCall(Node);
-        case ASTNode::ARRAY_ACCESS: return checkArrayAccess(Node);
-        case ASTNode::FIELD_ACCESS: return checkFieldAccess(Node);
-        case ASTNode::NEW_EXPR: return checkNewExpression(Node);
-        default: 
-            throw SemanticError("Unknown expression type", Node->getLine());
+Type SemanticAnalyzer::arrayTargetType(ASTNode* Node, const Type& arrayType, const Type& indexType) {
+    ASTNode* arrayASTNode = Node->getChild(0);
+    ASTNode* indexASTNode = Node->getChild(1);
+    
+    if (!arrayType.isArray()) {
+        throw SemanticError("Array access on non-array type: " + arrayType.toString(), 
+                         arrayASTNode->getLoc());
+    }
+    
+    if (!indexType.isInt()) {
+        throw SemanticError("Array index must be numeric, found: " + indexType.toString(), 
+                         indexASTNode->getLoc());
     }
+    
+    return arrayType.getElementType();
 }
 
-Type SemanticAnalyzer::checkLiteral(ASTNode* Node) {
-    std::string literalType = Node->getAttribute("literalType");
+Type SemanticAnalyzer::fieldTargetType(ASTNode* Node, const Type& objectType) {
+    ASTNode* objectASTNode = Node->getChild(0);
+    std::string fieldName(Node->getFieldText());
+    
+    if (!objectType.isClass()) {
+        throw SemanticError("Cannot access field on non-class type: " + objectType.toString(), 
+                         objectASTNode->getLoc());
+    }
+    
+    std::string className = objectType.toString();
+    Symbol* classSymbol = lookup(className);
     
-    if (literalType == "int") return Type::intType();
-    if (literalType == "float") return Type::floatType();
-    if (literalType == "double") return Type::doubleType();
-    if (literalType == "boolean") return Type::booleanType();
-    if (literalType == "char") return Type::charType();
-    if (literalType == "string") return Type::stringType();
-    if (literalType == "null") return Type::classType("null");
+    if (!classSymbol || !classSymbol->isClass()) {
+        throw SemanticError("Class not found: " + className, 
+                         Node->getLoc());
+    }
     
-    throw SemanticError("Unknown literal type: " + literalType, Node->getLine());
+    ClassSymbol* cls = static_cast<ClassSymbol*>(classSymbol);
+    Symbol* fieldSymbol = cls->getSymbolTable()->resolve(fieldName);
+    
+    if (!fieldSymbol) {
+        throw SemanticError("Field " + fieldName + " not found in class " + className, 
+                         Node->getLoc());
+    }
+    
+    return fieldSymbol->getType();
 }
 
-Type SemanticAnalyzer::checkVariable(ASTNode* Node) {
-    std::string varName = Node->getAttribute("name");
-    Symbol* symbol = currentScope->resolve(varName);
+void SemanticAnalyzer::checkExpression(ASTNode* Node) {
+    switch (Node->getType()) {
+        case ASTNode::LITERAL: checkLiteral(Node); break;
+        case ASTNode::VARIABLE: checkVariable(Node); break;
+        case ASTNode::ARRAY_INIT: checkArrayInitializer(Node); break;
+        case ASTNode::BINARY_EXPR: checkBinaryExpression(Node); break;
+        case ASTNode::UNARY_EXPR: checkUnaryExpression(Node); break;
+        case ASTNode::CONDITIONAL_EXPR: checkConditionalExpression(Node); break;
+        case ASTNode::METHOD_CALL: checkMethodCall(Node); break;
+        case ASTNode::ARRAY_ACCESS: checkArrayAccess(Node); break;
+        case ASTNode::FIELD_ACCESS: checkFieldAccess(Node); break;
+        case ASTNode::NEW_EXPR: checkNewExpression(Node); break;
+        default: 
+            throw SemanticError("Unknown expression type", Node->getLoc());
+    }
+}
+void SemanticAnalyzer::checkLiteral(ASTNode* Node) {
+    switch (Node->getLiteralKind()) {
+        case ASTNode::INT_LITERAL: types.push_back(Type::intType()); return;
+        case ASTNode::FLOAT_LITERAL: types.push_back(Type::floatType()); return;
+        case ASTNode::BOOLEAN_LITERAL: types.push_back(Type::booleanType()); return;
+        case ASTNode::CHAR_LITERAL: types.push_back(Type::charType()); return;
+        case ASTNode::STRING_LITERAL: types.push_back(Type::stringType()); return;
+        default: break;
+    }
+    
+    throw SemanticError("Unknown literal type: " + Node->getAttribute("literalType"), Node->getLoc());
+}
+void SemanticAnalyzer::checkVariable(ASTNode* Node) {
+    Symbol* symbol = lookup(Node->getName());
     
     if (!symbol) {
-        throw SemanticError("Undefined variable: " + varName, Node->getLine());
+        throw SemanticError("Undefined variable: " + std::string(Node->getNameText()), Node->getLoc());
     }
     
     if (!symbol->isVariable()) {
-        throw SemanticError(varName + " is not a variable", Node->getLine());
+        throw SemanticError(std::string(Node->getNameText()) + " is not a variable", Node->getLoc());
     }
     
-    return symbol->getType();
+    types.push_back(symbol->getType());
 }
 
-Type SemanticAnalyzer::checkBinaryExpression(ASTNode* Node) {
-    std::string op = Node->getAttribute("operator");
+void SemanticAnalyzer::checkBinaryExpression(ASTNode* Node) {
+    schedule(CHECK, Node->getChild(0));
+    schedule(CHECK, Node->getChild(1));
+    schedule(BINARY, Node);
+}
+Type SemanticAnalyzer::binaryExpressionType(ASTNode* Node, const Type& leftType, const Type& rightType) {
+    TokenKind op = Node->getOperator();
+    std::string opText(Node->getOperatorText());
     ASTNode* leftASTNode = Node->getChild(0);
-    ASTNode* rightASTNode = Node->getChild(1);
     
-    Type leftType = checkExpression(leftASTNode);
-    Type rightType = checkExpression(rightASTNode);
-    
-    if (op == "+" || op == "-" || op == "*" || op == "/" || op == "%") {
-        if (op == "+" && (leftType.isString() || rightType.isString())) {
+    if (op == PLUS || op == MINUS || op == STAR || op == SLASH || op == PERCENT) {
+        if (op == PLUS && (leftType.isString() || rightType.isString())) {
             return Type::stringType();
         }
         
         if (leftType.isNumeric() && rightType.isNumeric()) {
-            if (leftType.toString() == "double" || rightType.toString() == "double") {
-                return Type::doubleType();
-            } else if (leftType.toString() == "float" || rightType.toString() == "float") {
-                return Type::floatType();
+            Type doubleType = Type::doubleType();
+            Type floatType = Type::floatType();
+            if (leftType == doubleType || rightType == doubleType) {
+                return doubleType;
+            } else if (leftType == floatType || rightType == floatType) {
+                return floatType;
             }
             return Type::intType();
         }
         
-        throw SemanticError("Operator " + op + " cannot be applied to types " + 
+        throw SemanticError("Operator " + opText + " cannot be applied to types " + 
                          leftType.toString() + " and " + rightType.toString(), 
-                         Node->getLine());
+                         Node->getLoc());
     }
     
-    if (op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" || op == ">=") {
-        if ((op == "==" || op == "!=") && 
+    if (op == EQ_EQ || op == NOT_EQ || op == LESS || op == GREATER || op == LESS_EQ || op == GREATER_EQ) {
+        if ((op == EQ_EQ || op == NOT_EQ) && 
             (leftType.isAssignableTo(rightType) || rightType.isAssignableTo(leftType))) {
             return Type::booleanType();
         }
@@ -1218,40 +1958,73 @@ Type SemanticAnalyzer::checkBinaryExpression(ASTNode* Node) {
             return Type::booleanType();
         }
         
-        throw SemanticError("Operator " + op + " cannot be applied to types " + 
+        throw SemanticError("Operator " + opText + " cannot be applied to types " + 
                          leftType.toString() + " and " + rightType.toString(), 
-                         Node->getLine());
+                         Node->getLoc());
     }
     
-    if (op == "&&" || op == "||") {
+    if (op == SHIFT_LEFT || op == SHIFT_RIGHT || op == UNSIGNED_SHIFT_RIGHT) {
+        if ((leftType.isInt() || leftType.isChar()) && (rightType.isInt() || rightType.isChar())) {
+            return Type::intType();
+        }
+
+        throw SemanticError("Operator " + opText + " cannot be applied to types " + 
+                         leftType.toString() + " and " + rightType.toString(), 
+                         Node->getLoc());
+    }
+
+    if (op == AMP || op == PIPE || op == CARET) {
+        if (leftType.isBoolean() && rightType.isBoolean()) {
+            return Type::booleanType();
+        }
+        if ((leftType.isInt() || leftType.isChar()) && (rightType.isInt() || rightType.isChar())) {
+            return Type::intType();
+        }
+
+        throw SemanticError("Operator " + opText + " cannot be applied to types " + 
+                         leftType.toString() + " and " + rightType.toString(), 
+                         Node->getLoc());
+    }
+
+    if (op == AND_AND || op == OR_OR) {
         if (leftType.isBoolean() && rightType.isBoolean()) {
             return Type::booleanType();
         }
         
-        throw SemanticError("Operator " + op + " cannot be applied to types " + 
+        throw SemanticError("Operator " + opText + " cannot be applied to types " + 
                          leftType.toString() + " and " + rightType.toString(), 
-                         Node->getLine());
+                         Node->getLoc());
     }
-    if (op == "+=" || op == "-=" || op == "*=" || op == "/=") {
+    if (op == ASSIGN) {
+        if (!isLValue(leftASTNode)) {
+            throw SemanticError("Left operand must be assignable", Node->getLoc());
+        }
+        if (!rightType.isAssignableTo(leftType)) {
+            throw SemanticError("Cannot assign " + rightType.toString() + " to " + leftType.toString(),
+                Node->getLoc());
+        }
+        return leftType;
+    }
+    if (op == PLUS_ASSIGN || op == MINUS_ASSIGN || op == STAR_ASSIGN || op == SLASH_ASSIGN || op == PERCENT_ASSIGN) {
         // Проверяем, что левая часть - изменяемая переменная
         if (!isLValue(leftASTNode)) {
-            throw SemanticError("Left operand must be assignable", Node->getLine());
+            throw SemanticError("Left operand must be assignable", Node->getLoc());
         }
         
         // Вычисляем тип результата операции
-        Type operationType = checkOperationType(op[0], leftType, rightType, Node->getLine());
+        Type operationType = checkOperationType(opText[0], leftType, rightType, Node->getLoc());
         
         // Проверяем совместимость типов
         if (!operationType.isAssignableTo(leftType)) {
-            throw SemanticError("Cannot apply '" + op + "' to " + 
+            throw SemanticError("Cannot apply '" + opText + "' to " + 
                 leftType.toString() + " and " + rightType.toString(),
-                Node->getLine());
+                Node->getLoc());
         }
         
         return leftType; // Тип выражения совпадает с типом левого операнда
     }
-    throw SemanticError("Unknown binary operator: " + op, 
-                     Node->getLine());
+    throw SemanticError("Unknown binary operator: " + opText, 
+                     Node->getLoc());
 }
 
 bool SemanticAnalyzer::isLValue(ASTNode* node) {
@@ -1260,7 +2033,7 @@ bool SemanticAnalyzer::isLValue(ASTNode* node) {
            node->getType() == ASTNode::FIELD_ACCESS;
 }
 
-Type SemanticAnalyzer::checkOperationType(char op, Type left, Type right, int line) {
+Type SemanticAnalyzer::checkOperationType(char op, Type left, Type right, SourceLoc loc) {
     switch(op) {
         case '+':
             if (left.isString() || right.isString()) {
@@ -1273,139 +2046,199 @@ Type SemanticAnalyzer::checkOperationType(char op, Type left, Type right, int li
         case '-':
         case '*':
         case '/':
+        case '%':
             if (left.isNumeric() && right.isNumeric()) {
                 return getNumericResultType(left, right);
             }
             break;
     }
     
-    throw SemanticError("Invalid operation for types", line);
+    throw SemanticError("Invalid operation for types", loc);
 }
 
-Type SemanticAnalyzer::getNumericResultType(Type t1, Type t2) {
-    const std::map<std::string, int> typeRanks = {
-        {"double", 4}, 
-        {"float", 3}, 
-        {"int", 2}, 
-        {"Integer", 2},
-        {"char", 1}
-    };
+namespace {
 
-    std::string type1 = t1.toString();
-    std::string type2 = t2.toString();
-    
-    if (typeRanks.at(type1) > typeRanks.at(type2)) {
+// Ранг числового типа: результат операции получает тип с большим рангом
+int numericRank(const Type& type) {
+    TypeId id = type.getId();
+    if (id == TypeTable::primitiveId(Type::DOUBLE)) return 4;
+    if (id == TypeTable::primitiveId(Type::FLOAT)) return 3;
+    if (type.isInt()) return 2;
+    if (id == TypeTable::primitiveId(Type::CHAR)) return 1;
+    throw std::out_of_range("Not a numeric type: " + type.toString());
+}
+
+} // namespace
+
+Type SemanticAnalyzer::getNumericResultType(Type t1, Type t2) {
+    if (numericRank(t1) > numericRank(t2)) {
         return t1;
     }
     return t2;
 }
 
-Type SemanticAnalyzer::checkUnaryExpression(ASTNode* Node) {
-    std::string op = Node->getAttribute("operator");
-    ASTNode* exprASTNode = Node->getChild(0);
-    Type exprType = checkExpression(exprASTNode);
+void SemanticAnalyzer::checkUnaryExpression(ASTNode* Node) {
+    schedule(CHECK, Node->getChild(0));
+    schedule(UNARY, Node);
+}
+
+Type SemanticAnalyzer::unaryExpressionType(ASTNode* Node, const Type& exprType) {
+    TokenKind op = Node->getOperator();
+    std::string opText(Node->getOperatorText());
     
-    if (op == "-") {
+    if (op == MINUS) {
         if (exprType.isNumeric()) {
             return exprType;
         }
         
         throw SemanticError("Operator - cannot be applied to type " + exprType.toString(), 
-                         Node->getLine());
+                         Node->getLoc());
     }
     
-    if (op == "--") {
+    if (op == PLUS) {
+        if (exprType.isNumeric()) {
+            return exprType;
+        }
+
+        throw SemanticError("Operator + cannot be applied to type " + exprType.toString(), 
+                         Node->getLoc());
+    }
+
+    if (op == TILDE) {
+        if (exprType.isInt() || exprType.isChar()) {
+            return Type::intType();
+        }
+
+        throw SemanticError("Operator ~ cannot be applied to type " + exprType.toString(), 
+                         Node->getLoc());
+    }
+
+    if (op == MINUS_MINUS) {
         if (exprType.isNumeric()) {
             return exprType;
         }
         
         throw SemanticError("Operator -- cannot be applied to type " + exprType.toString(), 
-                         Node->getLine());
+                         Node->getLoc());
     }
 
-    if (op == "++") {
+    if (op == PLUS_PLUS) {
         if (exprType.isNumeric()) {
             return exprType;
         }
         
         throw SemanticError("Operator ++ cannot be applied to type " + exprType.toString(), 
-                         Node->getLine());
+                         Node->getLoc());
     }
 
-    if (op == "!") {
+    if (op == NOT) {
         if (exprType.isBoolean()) {
             return Type::booleanType();
         }
 
         throw SemanticError("Operator ! cannot be applied to type " + exprType.toString(), 
-                         Node->getLine());
+                         Node->getLoc());
     }
     
-    throw SemanticError("Unknown unary operator: " + op, 
-                     Node->getLine());
+    throw SemanticError("Unknown unary operator: " + opText, 
+                     Node->getLoc());
 }
 
-Type SemanticAnalyzer::checkMethodCall(ASTNode* Node) {
-    std::string methodName = Node->getAttribute("name");
-    
+void SemanticAnalyzer::checkConditionalExpression(ASTNode* Node) {
+    schedule(CHECK, Node->getChild(0));
+    schedule(TERNARY_CONDITION, Node);
+    schedule(CHECK, Node->getChild(1));
+    schedule(CHECK, Node->getChild(2));
+    schedule(TERNARY, Node);
+}
+
+Type SemanticAnalyzer::conditionalExpressionType(ASTNode* Node, const Type& thenType, const Type& elseType) {
+    if (thenType.isNumeric() && elseType.isNumeric()) {
+        return getNumericResultType(thenType, elseType);
+    }
+    if (elseType.isAssignableTo(thenType)) {
+        return thenType;
+    }
+    if (thenType.isAssignableTo(elseType)) {
+        return elseType;
+    }
+
+    throw SemanticError("Incompatible types in ?: " + thenType.toString() + " and " + elseType.toString(),
+                     Node->getLoc());
+}
+
+void SemanticAnalyzer::checkMethodCall(ASTNode* Node) {
     if (Node->getChildCount() > 0 && Node->getChild(0)->getType() == ASTNode::FIELD_ACCESS) {
-        ASTNode* objectNode = Node->getChild(0);
-        Type objectType = checkExpression(objectNode);
-        methodName = objectNode->getAttribute("field");
-
-        // Получаем класс объекта
-        Symbol* symb = currentScope->resolve(objectNode->getChild(0)->getAttribute("name"));
-        std::string s = symb->getType().toString();
-        s = s.erase(s.find("<"), s.find(">") - s.find("<") + 1);
-        ClassSymbol* classSymbol = dynamic_cast<ClassSymbol*>(globalScope->resolve(s));
-        if (!classSymbol) {
-            if(!classSymbol){
-                throw SemanticError("Class '" + objectType.toString() + "' not found", Node->getLine());
-            }
-        }
-        
-        std::map<std::string, Type> genericMap;
-        if (symb->getType().isGenericInstance()) {
-            auto params = classSymbol->getGenericParams();
-            auto args = symb->getType().getGenericArguments();
-            for (size_t i = 0; i < params.size() && i < args.size(); ++i) {
-                genericMap[params[i]] = args[i];
-            }
-        }
+        schedule(CHECK, Node->getChild(0));
+        schedule(OBJECT_CALL, Node);
+        return;
+    }
+
+    for (size_t i = 0; i < Node->getChildCount(); i++) {
+        schedule(CHECK, Node->getChild(i));
+    }
+    schedule(CALL, Node);
+}
+
+void SemanticAnalyzer::checkObjectMethodCall(ASTNode* Node) {
+    ASTNode* objectNode = Node->getChild(0);
+    Type objectType = popType();
+    std::string methodName(objectNode->getFieldText());
 
-        // Ищем метод в классе
-        Symbol* methodSymbol = classSymbol->getSymbolTable()->resolve(methodName);
-        if (!methodSymbol || !methodSymbol->isFunction()) {
-            throw SemanticError("Method '" + methodName + "' not found in class " + objectType.toString(), Node->getLine());
+    // Получаем класс объекта
+    Symbol* symb = lookup(objectNode->getChild(0)->getName());
+    std::string s = symb->getType().toString();
+    s = s.erase(s.find("<"), s.find(">") - s.find("<") + 1);
+    ClassSymbol* classSymbol = dynamic_cast<ClassSymbol*>(globalScope->resolve(s));
+    if (!classSymbol) {
+        if(!classSymbol){
+            throw SemanticError("Class '" + objectType.toString() + "' not found", Node->getLoc());
+        }
+    }
+    
+    std::map<std::string, Type> genericMap;
+    if (symb->getType().isGenericInstance()) {
+        auto params = classSymbol->getGenericParams();
+        auto args = symb->getType().getGenericArguments();
+        for (size_t i = 0; i < params.size() && i < args.size(); ++i) {
+            genericMap[params[i]] = args[i];
         }
-        
-        // Проверяем параметры
-        FunctionSymbol* method = static_cast<FunctionSymbol*>(methodSymbol);
-        checkMethodParameters(Node, method, genericMap);
-        return method->getType();
     }
 
-    std::vector<Type> argTypes;
-    for (size_t i = 0; i < Node->getChildCount(); i++) {
-        argTypes.push_back(checkExpression(Node->getChild(i)));
+    // Ищем метод в классе
+    Symbol* methodSymbol = classSymbol->getSymbolTable()->resolve(methodName);
+    if (!methodSymbol || !methodSymbol->isFunction()) {
+        throw SemanticError("Method '" + methodName + "' not found in class " + objectType.toString(), Node->getLoc());
     }
     
+    // Проверяем параметры; тип вызова остаётся под ними
+    FunctionSymbol* method = static_cast<FunctionSymbol*>(methodSymbol);
+    types.push_back(method->getType());
+    checkMethodParameters(Node, method, genericMap);
+}
+
+void SemanticAnalyzer::finishMethodCall(ASTNode* Node) {
+    std::string methodName(Node->getNameText());
+    std::vector<Type> argTypes(types.end() - Node->getChildCount(), types.end());
+    types.resize(types.size() - argTypes.size());
+    
     if (methodName == "System.out.println") {
         if (argTypes.size() > 1) {
             throw SemanticError("System.out.println requires exactly less than two arguments", 
-                             Node->getLine());
+                             Node->getLoc());
         }
-        return Type::voidType();
+        types.push_back(Type::voidType());
+        return;
     }
     
-    Symbol* symbol = currentScope->resolve(methodName);
+    Symbol* symbol = lookup(Node->getName());
     
     if (!symbol) {
-        throw SemanticError("Undefined method: " + methodName, Node->getLine());
+        throw SemanticError("Undefined method: " + methodName, Node->getLoc());
     }
     
     if (!symbol->isFunction()) {
-        throw SemanticError(methodName + " is not a method", Node->getLine());
+        throw SemanticError(methodName + " is not a method", Node->getLoc());
     }
     
     FunctionSymbol* method = static_cast<FunctionSymbol*>(symbol);
@@ -1414,18 +2247,18 @@ Type SemanticAnalyzer::checkMethodCall(ASTNode* Node) {
         throw SemanticError("Method " + methodName + " expects " + 
                          std::to_string(method->getParameterCount()) + 
                          " arguments, but got " + std::to_string(argTypes.size()), 
-                         Node->getLine());
+                         Node->getLoc());
     }
     
     for (size_t i = 0; i < argTypes.size(); i++) {
         if (!argTypes[i].isAssignableTo(method->getParameterType(i))) {
             throw SemanticError("Argument type mismatch for parameter " + 
                              std::to_string(i+1) + " of method " + methodName, 
-                             Node->getChild(i)->getLine());
+                             Node->getChild(i)->getLoc());
         }
     }
     
-    return method->getType();
+    types.push_back(method->getType());
 }
 
 void SemanticAnalyzer::checkMethodParameters(ASTNode* callNode, FunctionSymbol* method, const std::map<std::string, Type>& genericMap) {
@@ -1435,19 +2268,19 @@ void SemanticAnalyzer::checkMethodParameters(ASTNode* callNode, FunctionSymbol*
     if (expectedCount != actualCount) {
         throw SemanticError("Method expects " + std::to_string(expectedCount) + 
                           " parameters, got " + std::to_string(actualCount),
-                          callNode->getLine());
+                          callNode->getLoc());
     }
 
-    for (size_t i = 0; i < actualCount; ++i) {
+    // Ожидаемые типы кладутся в обратном порядке: к проверке каждого
+    // аргумента его параметр оказывается на вершине стека
+    for (size_t i = actualCount; i-- > 0;) {
         Type paramType = method->getParameterType(i);
         // Заменяем generic-параметры в типе параметра
-        Type resolvedParam = resolveTypeWithSubstitution(paramType, genericMap);
-        Type argType = checkExpression(callNode->getChild(i + 1));
-
-        if (!argType.isAssignableTo(resolvedParam)) {
-            throw SemanticError("Parameter type mismatch: expected " + resolvedParam.toString() + 
-                              ", got " + argType.toString(), callNode->getChild(i + 1)->getLine());
-        }
+        types.push_back(resolveTypeWithSubstitution(paramType, genericMap));
+    }
+    for (size_t i = 0; i < actualCount; ++i) {
+        schedule(CHECK, callNode->getChild(i + 1));
+        schedule(CALL_ARGUMENT, callNode, i + 1);
     }
 
     // for (size_t i = 0; i < actualCount; i++) {
@@ -1477,50 +2310,38 @@ Type SemanticAnalyzer::resolveTypeWithSubstitution(const Type& type, const std::
     return type;
 }
 
-Type SemanticAnalyzer::checkArrayAccess(ASTNode* Node) {
-    ASTNode* arrayNode = Node->getChild(0);
-    Type arrayType = checkExpression(arrayNode);
-    
-    if (!arrayType.isArray()) {
-        throw SemanticError("Array access on non-array type", Node->getLine());
-    }
-    
-    ASTNode* indexNode = Node->getChild(1);
-    Type indexType = checkExpression(indexNode);
-    
-    if (!indexType.isInt()) {
-        throw SemanticError("Array index must be numeric", indexNode->getLine());
-    }
-    
-    return arrayType.getElementType();
+void SemanticAnalyzer::checkArrayAccess(ASTNode* Node) {
+    schedule(CHECK, Node->getChild(0));
+    schedule(ARRAY_ACCESS_ARRAY, Node);
+    schedule(CHECK, Node->getChild(1));
+    schedule(ARRAY_ACCESS_INDEX, Node);
 }
-
-Type SemanticAnalyzer::checkArrayInitializer(ASTNode* Node) {
+void SemanticAnalyzer::checkArrayInitializer(ASTNode* Node) {
     if (Node->getChildCount() == 0) {
-        return Type::arrayType(Type::voidType(), 1); // Нельзя определить тип пустого массива
+        types.push_back(Type::arrayType(Type::voidType(), 1)); // Нельзя определить тип пустого массива
+        return;
     }
 
-    // Определяем тип элементов по первому элементу
-    Type elementType = checkExpression(Node->getChild(0));
-    
-    // Проверяем совместимость всех элементов
+    // Тип элементов определяется по первому элементу и лежит в стеке,
+    // пока проверяется совместимость остальных
+    schedule(CHECK, Node->getChild(0));
     for (size_t i = 1; i < Node->getChildCount(); i++) {
-        Type currentType = checkExpression(Node->getChild(i));
-        if (!currentType.isAssignableTo(elementType)) {
-            throw SemanticError("Inconsistent array element types", Node->getLine());
-        }
+        schedule(CHECK, Node->getChild(i));
+        schedule(ARRAY_INIT_ELEMENT, Node);
     }
-
-    return Type::arrayType(elementType, 1);
+    schedule(ARRAY_INIT_END, Node);
+}
+void SemanticAnalyzer::checkFieldAccess(ASTNode* Node) {
+    schedule(CHECK, Node->getChild(0));
+    schedule(FIELD, Node);
 }
 
-Type SemanticAnalyzer::checkFieldAccess(ASTNode* Node) {
+Type SemanticAnalyzer::fieldAccessType(ASTNode* Node, const Type& objectType) {
     ASTNode* objectASTNode = Node->getChild(0);
-    std::string fieldName = Node->getAttribute("field");
+    std::string fieldName(Node->getFieldText());
     
-    Type objectType = checkExpression(objectASTNode);
-    
-    if (objectType.toString() == "System" && fieldName == "out") {
+    static const Type systemType = Type::classType("System");
+    if (objectType == systemType && fieldName == "out") {
         return Type::classType("PrintStream");
     }
     
@@ -1531,17 +2352,17 @@ Type SemanticAnalyzer::checkFieldAccess(ASTNode* Node) {
     
     if (!baseType.isClass()) {
         throw SemanticError("Cannot access field on non-class type: " + objectType.toString(),
-                          objectASTNode->getLine());
+                          objectASTNode->getLoc());
     }
     
     std::string className = baseType.toString();
-    Symbol* classSymbol = currentScope->resolve(className);
+    Symbol* classSymbol = lookup(className);
     
     if (!classSymbol) {
         // if(!classSymbol->isClass())
         classSymbol = globalScope->resolve(className);
         if(!classSymbol){
-            throw SemanticError("Class not found: " + className, Node->getLine());
+            throw SemanticError("Class not found: " + className, Node->getLoc());
         }
     }
     ClassSymbol* cls = static_cast<ClassSymbol*>(classSymbol);
@@ -1549,87 +2370,135 @@ Type SemanticAnalyzer::checkFieldAccess(ASTNode* Node) {
     
     if (!fieldSymbol) {
         throw SemanticError("Field " + fieldName + " not found in class " + objectType.toString(),
-                          Node->getLine());
+                          Node->getLoc());
     }
     
     return fieldSymbol->getType();
 }
 
-Type SemanticAnalyzer::checkNewExpression(ASTNode* Node) {
-    std::string typeName = Node->getAttribute("type");
+void SemanticAnalyzer::checkNewExpression(ASTNode* Node) {
+    std::string typeName(Node->getTypeNameText());
     
     if (Node->getAttribute("isArray") == "true") {
-        ASTNode* sizeASTNode = Node->getChild(0);
-        Type sizeType = checkExpression(sizeASTNode);
-        
-        if (!sizeType.isInt()) {
-            throw SemanticError("Array size must be int, found: " + sizeType.toString(), 
-                             sizeASTNode->getLine());
-        }
-        
-        Type elementType = resolveType(typeName, Node->getLine());
-        return Type::arrayType(elementType);
+        schedule(CHECK, Node->getChild(0));
+        schedule(NEW_ARRAY, Node);
+        return;
     }
     
-    Type classType = resolveType(typeName, Node->getLine());
+    Type classType = resolveNodeType(Node);
     
     if (!classType.isClass()) {
         throw SemanticError("Cannot create an instance of non-class type: " + typeName, 
-                         Node->getLine());
+                         Node->getLoc());
     }
     
-    Symbol* classSymbol = currentScope->resolve(typeName);
+    Symbol* classSymbol = lookup(typeName);
     
     if (!classSymbol || !classSymbol->isClass()) {
         throw SemanticError("Class not found: " + typeName, 
-                         Node->getLine());
+                         Node->getLoc());
     }
     
-    return classType;
+    types.push_back(classType);
 }
 
+// Те же правила, что у прежнего рекурсивного варианта, но со стеком
+// кадров вместо вызовов. Кадр просматривает детей своего узла; когда нужен
+// ответ для ребёнка, кадр запоминает, чего ждёт (step), и кладёт в стек
+// кадр ребёнка. Ответ снятого кадра лежит в result.
+//   return        - есть return
+//   if без else   - return в ветке then
+//   if с else     - ответ узла: return в обеих ветках
+//   switch        - ответ узла: return во всех case и default
+//   прочие узлы   - return где-то внутри
 bool SemanticAnalyzer::hasReturnStatement(ASTNode* node) {
-    if (!node) return false;
+    enum Step { SCAN, CHILD, IF_THEN, IF_ELSE, SWITCH_CASE };
+    struct Frame {
+        ASTNode* node;
+        size_t index;       // текущий ребёнок
+        Step step;
+        size_t caseIndex;   // текущий case у switch
+        bool thenHasReturn;
+    };
 
-    // Рекурсивно проверяем все дочерние узлы
-    for (size_t i = 0; i < node->getChildCount(); ++i) {
-        ASTNode* child = node->getChild(i);
-        
-        // Если нашли прямой return - сразу true
-        if (child->getType() == ASTNode::RETURN_STMT) return true;
-        
-        // Особые случаи для управляющих конструкций
-        switch (child->getType()) {
-            case ASTNode::BLOCK:
-                if (hasReturnStatement(child)) return true;
+    std::vector<Frame> stack;
+    bool result = false;
+    auto call = [&](ASTNode* target) {
+        stack.push_back(Frame{target, 0, SCAN, 0, false});
+    };
+    // Ответ для кадра на вершине стека
+    auto finish = [&](bool answer) {
+        result = answer;
+        stack.pop_back();
+    };
+
+    call(node);
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (!frame.node) {
+            finish(false);
+            continue;
+        }
+        ASTNode* child = frame.node->getChild(frame.index);
+        switch (frame.step) {
+            case SCAN:
+                if (!child) {
+                    finish(false);
+                } else if (child->getType() == ASTNode::RETURN_STMT) {
+                    finish(true);
+                } else if (child->getType() == ASTNode::IF_STMT) {
+                    frame.step = IF_THEN;
+                    call(child->getChild(1));
+                } else if (child->getType() == ASTNode::SWITCH_STMT) {
+                    if (child->getChildCount() <= 1) {
+                        finish(true);
+                    } else {
+                        frame.step = SWITCH_CASE;
+                        frame.caseIndex = 1;
+                        call(child->getChild(1));
+                    }
+                } else {
+                    frame.step = CHILD;
+                    call(child);
+                }
                 break;
-                
-            case ASTNode::IF_STMT: {
-                bool thenHasReturn = hasReturnStatement(child->getChild(1));
-                bool elseHasReturn = child->getChildCount() > 2 
-                    ? hasReturnStatement(child->getChild(2))
-                    : false;
-                
-                // Если есть else - требуем return в обеих ветках
-                if (child->getChildCount() > 2 && !(thenHasReturn && elseHasReturn))
-                    return false;
-                
-                if (thenHasReturn || elseHasReturn) return true;
+
+            case CHILD:
+                if (result) {
+                    finish(true);
+                } else {
+                    frame.step = SCAN;
+                    frame.index++;
+                }
                 break;
-            }
-            
-            case ASTNode::SWITCH_STMT:
-                // Проверяем все case и default
-                for (size_t j = 1; j < child->getChildCount(); ++j) {
-                    if (!hasReturnStatement(child->getChild(j)))
-                        return false;
+
+            case IF_THEN:
+                frame.thenHasReturn = result;
+                if (child->getChildCount() > 2) {
+                    frame.step = IF_ELSE;
+                    call(child->getChild(2));
+                } else if (result) {
+                    finish(true);
+                } else {
+                    frame.step = SCAN;
+                    frame.index++;
                 }
-                return true;
-            
-            default:
-                if (hasReturnStatement(child)) return true;
+                break;
+
+            case IF_ELSE:
+                finish(frame.thenHasReturn && result);
+                break;
+
+            case SWITCH_CASE:
+                if (!result) {
+                    finish(false);
+                } else if (++frame.caseIndex < child->getChildCount()) {
+                    call(child->getChild(frame.caseIndex));
+                } else {
+                    finish(true);
+                }
+                break;
         }
     }
-    
-    return false;
-}
\ No newline at end of file
+    return result;
+}
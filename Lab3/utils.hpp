@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <set>
@@ -12,6 +13,16 @@
 #include <algorithm>
 #include <cassert>
 #include <sstream>   
+#include <unordered_map>
+#include <type_traits>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <cstdint>
+#include <deque>
+#include "../Lab2/headers/interner.hpp"
+#include "../Lab2/headers/lexicon.hpp"
+#include "../Lab2/headers/source_loc.hpp"
 
 class Type;
 class Symbol;
@@ -19,7 +30,71 @@ class SymbolTable;
 class FunctionSymbol;
 class ClassSymbol;
 class Node;
+class AstArena;
 
+// Арена дерева разбора. Узлы, массивы их детей и строки атрибутов
+// выделяются подряд в больших блоках и освобождаются все сразу вместе с
+// ареной, без обхода дерева. Деструкторы размещённых объектов не
+// вызываются, поэтому в арене живут только такие типы, которым они не нужны.
+class AstArena {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    AstArena() = default;
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment) {
+        size_t offset = (used + alignment - 1) & ~(alignment - 1);
+        if (offset + size > capacity) {
+            // начало блока выровнено operator new
+            addBlock(size);
+            offset = 0;
+        }
+        used = offset + size;
+        return current + offset;
+    }
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "деструкторы объектов в арене не вызываются");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Копия строки, которая живёт до освобождения арены
+    std::string_view copy(std::string_view text);
+
+    // Отдельная арена, которая освобождается вместе с этой: своя для
+    // каждого потока, строящего часть дерева. Сама арена не потокобезопасна,
+    // поэтому дочерние создаются до запуска потоков.
+    AstArena& spawn();
+
+    size_t bytesAllocated() const;
+
+private:
+    void addBlock(size_t minimum);
+
+    std::vector<std::unique_ptr<AstArena>> spawned;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<size_t> blockSizes;
+    char* current = nullptr;
+    size_t used = 0;
+    size_t capacity = 0;
+};
+
+// Номер типа в TypeTable; одинаковые типы получают один номер
+using TypeId = uint32_t;
+constexpr TypeId NO_TYPE = UINT32_MAX;
+
+// Тип - номер записи в TypeTable::global(), поэтому копируется как число.
+// Составные части (тип элемента, аргументы обобщённого типа) хранятся в
+// таблице, а не в каждой копии.
 class Type {
 public:
     enum Kind {
@@ -76,16 +151,74 @@ public:
     bool operator==(const Type& other) const;
     bool operator!=(const Type& other) const;
     
-    std::string toString() const;
+    // Текст хранится в TypeTable, копии не создаются
+    const std::string& toString() const;
+    TypeId getId() const { return id; }
+    // Тип по номеру из TypeTable, например запомненному в узле дерева
+    static Type fromId(TypeId id) { return Type(id); }
 
 private:
-    Kind kind;
-    PrimitiveKind primitiveKind;
-    std::string className;
-    int arrayDimension;
-    std::string genericParamName;              
-    std::shared_ptr<Type> genericBaseType;     
-    std::vector<Type> genericTypeArguments;
+    friend class TypeTable;
+    explicit Type(TypeId id) : id(id) {}
+
+    TypeId id;
+};
+
+// Таблица всех различных типов. Ключ записи приводится к каноническому
+// виду: поля, которые правила сравнения типов не различают, обнуляются.
+// Поэтому равные типы получают один номер, и сравнение - это сравнение
+// номеров. Записи лежат в deque и не переезжают, так что ссылка из
+// entry() остаётся верной после intern().
+class TypeTable {
+public:
+    struct Entry {
+        Type::Kind kind = Type::VOID;
+        Type::PrimitiveKind primitiveKind = Type::BOOLEAN;
+        SymbolId className = NO_SYMBOL;
+        int arrayDimension = 0;
+        SymbolId genericParamName = NO_SYMBOL;
+        TypeId genericBase = NO_TYPE;
+        uint32_t firstArgument = 0; // в arguments
+        uint32_t argumentCount = 0;
+    };
+
+    TypeTable();
+    TypeTable(const TypeTable&) = delete;
+    TypeTable& operator=(const TypeTable&) = delete;
+
+    // Номер типа с полями fields; аргументы учитываются только у GENERIC_INSTANCE
+    TypeId intern(const Entry& fields, const std::vector<TypeId>& args = {});
+    const Entry& entry(TypeId id) const { return entries[id]; }
+    // toString() типа, строится один раз при добавлении; ссылка не
+    // меняется при добавлении новых типов
+    const std::string& text(TypeId id) const { return texts[id]; }
+    std::vector<TypeId> argumentsOf(const Entry& entry) const;
+
+    // void, затем примитивы в порядке PrimitiveKind
+    static TypeId primitiveId(Type::PrimitiveKind kind) { return 1 + kind; }
+    static constexpr TypeId VOID_ID = 0;
+    // Класс Integer, который правила типов считают числом
+    TypeId integerClass() const { return integerClassId; }
+    SymbolId integerName() const { return integerNameId; }
+
+    static TypeTable& global();
+
+private:
+    static constexpr size_t INITIAL_SLOTS = 256;
+
+    static Entry canonical(const Entry& key);
+    static uint64_t hashOf(const Entry& key, const std::vector<TypeId>& args);
+    bool sameKey(const Entry& entry, const Entry& key, const std::vector<TypeId>& args) const;
+    std::string buildText(TypeId id) const;
+    void grow();
+
+    std::deque<Entry> entries;
+    std::deque<std::string> texts;
+    std::vector<uint64_t> hashes;
+    std::vector<TypeId> arguments;
+    std::vector<TypeId> slots; // NO_TYPE - свободная ячейка
+    SymbolId integerNameId = NO_SYMBOL;
+    TypeId integerClassId = NO_TYPE;
 };
 
 class Symbol {
@@ -98,9 +231,11 @@ public:
     };
 
     Symbol(const std::string& name, const Type& type, Kind kind);
+    Symbol(SymbolId id, const Type& type, Kind kind);
     virtual ~Symbol();
 
-    const std::string& getName() const;
+    SymbolId getId() const;
+    std::string_view getName() const;
     const Type& getType() const;
     Kind getKind() const;
 
@@ -109,7 +244,7 @@ public:
     bool isClass() const;
 
 protected:
-    std::string name;
+    SymbolId id;
     Type type;
     Kind kind;
 };
@@ -143,31 +278,74 @@ private:
     std::vector<std::string> genericParams;
 };
 
+// Имена одного уровня без вложенности: члены класса или глобальные имена
 class SymbolTable {
 public:
-    SymbolTable(SymbolTable* parent = nullptr);
-    
     void define(Symbol* symbol);
+    Symbol* resolve(SymbolId id) const;
     Symbol* resolve(const std::string& name) const;
+    Symbol* resolveLocally(SymbolId id) const;
     Symbol* resolveLocally(const std::string& name) const;
-    SymbolTable* getParent() const;
 
 private:
-    SymbolTable* parent;
-    std::map<std::string, std::unique_ptr<Symbol>> symbols;
+    std::unordered_map<SymbolId, std::unique_ptr<Symbol>> symbols;
+};
+
+// Вложенные области видимости тел методов в одной хеш-таблице с открытой
+// адресацией по SymbolId. Ячейка хранит последнее объявление имени, а
+// объявление - номер объявления, которое оно затеняет. Массив объявлений
+// служит журналом отката: exitScope() снимает объявления своей области с
+// конца и возвращает ячейкам затенённые. Поиск - одна проба при любой
+// вложенности, вход в область - запись одного числа.
+class ScopedSymbolTable {
+public:
+    ScopedSymbolTable();
+
+    void enterScope();
+    void exitScope();
+    // Число открытых областей; 0 - ни одной
+    size_t depth() const;
+
+    // Таблица владеет symbol, пока не закрыта его область
+    void define(Symbol* symbol);
+    Symbol* resolve(SymbolId id) const;
+    // Только объявления текущей области
+    Symbol* resolveLocally(SymbolId id) const;
+
+private:
+    static constexpr size_t INITIAL_SLOTS = 64;
+    static constexpr uint32_t NO_BINDING = UINT32_MAX;
+
+    struct Slot {
+        SymbolId id;
+        uint32_t top; // последнее объявление или NO_BINDING
+    };
+    struct Binding {
+        std::unique_ptr<Symbol> symbol;
+        uint32_t shadowed; // предыдущее объявление того же имени
+        uint32_t scope;    // глубина области объявления
+    };
+
+    size_t findSlot(SymbolId id) const;
+    void grow();
+
+    std::vector<Slot> slots;
+    size_t usedSlots = 0;
+    std::vector<Binding> bindings;     // журнал отката
+    std::vector<uint32_t> scopeStarts; // размер журнала при входе в область
 };
 
 class SemanticError : public std::runtime_error {
 public:
-    SemanticError(const std::string& message, int line);
+    SemanticError(const std::string& message, SourceLoc loc);
     
-    int getLine() const;
+    SourceLoc getLoc() const;
     const std::string& getErrorMessage() const;
 
 private:
-    static std::string buildMessage(const std::string& message, int line);
+    static std::string buildMessage(const std::string& message, SourceLoc loc);
     
-    int line;
+    SourceLoc loc;
     std::string message;
 };
 
@@ -202,30 +380,119 @@ public:
         ARRAY_ACCESS,
         FIELD_ACCESS,
         NEW_EXPR,
-        ASSIGNMENT
+        ASSIGNMENT,
+        CONDITIONAL_EXPR    // условие ? значение : значение
     };
 
-    ASTNode(NodeType type, int line);
-    virtual ~ASTNode();
+    enum LiteralKind : unsigned char {
+        NO_LITERAL,
+        INT_LITERAL,
+        FLOAT_LITERAL,
+        CHAR_LITERAL,
+        STRING_LITERAL,
+        BOOLEAN_LITERAL
+    };
+
+    // Узлы создаются только в арене: AstArena::create<ASTNode>(type, loc, arena)
+    ASTNode(NodeType type, SourceLoc loc, AstArena& arena);
 
     NodeType getType() const;
-    int getLine() const;
+    SourceLoc getLoc() const;
 
     void addChild(ASTNode* child);
     ASTNode* getChild(size_t index) const;
     size_t getChildCount() const;
 
-    void print(const std::string& prefix = "", bool isLast = true);
-    
-    void setAttribute(const std::string& key, const std::string& value);
+    // Удаляет детей, для которых pred(child) истинно, сохраняя порядок остальных
+    template <typename Pred>
+    void removeChildrenIf(Pred pred) {
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < childCount; i++) {
+            if (!pred(static_cast<const ASTNode*>(children[i]))) {
+                children[kept++] = children[i];
+            }
+        }
+        childCount = kept;
+    }
+
+    // Имя типа узла ("BINARY_EXPR") и его поля в порядке ключей, как их
+    // выводит дамп дерева (см. ast_dump.hpp)
+    std::string toString() const;
+    std::vector<std::pair<std::string_view, std::string>> attributeList() const;
+
+    // Произвольные атрибуты для отладки и внешних инструментов. Анализатор и
+    // генератор пользуются типизированными полями ниже; getAttribute видит
+    // и их под прежними ключами ("name", "type", "operator", ...)
+    void setAttribute(const std::string& key, std::string_view value);
     std::string getAttribute(const std::string& key) const;
 
+    // Имя узла в виде номера из пула строк
+    void setName(SymbolId id);
+    SymbolId getName() const;
+    std::string_view getNameText() const;
+
+    // Имя поля или метода в FIELD_ACCESS
+    void setField(SymbolId id);
+    SymbolId getField() const;
+    std::string_view getFieldText() const;
+
+    // Тип объявления как записан в исходнике; для METHOD_DECL - тип результата
+    void setTypeName(SymbolId id);
+    SymbolId getTypeName() const;
+    std::string_view getTypeNameText() const;
+
+    // Оператор BINARY_EXPR и UNARY_EXPR
+    void setOperator(TokenKind op, bool postfix = false);
+    TokenKind getOperator() const;
+    std::string_view getOperatorText() const;
+    bool isPostfix() const;
+
+    // Тип typeName, разрешённый анализатором; NO_TYPE - ещё не разрешён
+    void setResolvedType(TypeId id);
+    TypeId getResolvedType() const;
+
+    // Литерал: текст из исходника и разобранное значение
+    void setLiteral(LiteralKind kind, std::string_view text);
+    LiteralKind getLiteralKind() const;
+    std::string_view getLiteralText() const;
+    int64_t getIntValue() const;     // INT_LITERAL, CHAR_LITERAL (код символа)
+    double getFloatValue() const;    // FLOAT_LITERAL
+    bool getBoolValue() const;       // BOOLEAN_LITERAL
+
 private:
-    std::string toString();
     NodeType type;
-    int line;
-    std::vector<ASTNode*> children;
-    std::map<std::string, std::string> attributes;
+    SourceLoc loc; // позиция в исходнике, см. LineTable
+    SymbolId name;
+    SymbolId field = NO_SYMBOL;
+    SymbolId typeName = NO_SYMBOL;
+    TypeId resolvedType = NO_TYPE;
+    TokenKind op = TK_NONE;
+    bool postfix = false;
+    LiteralKind literalKind = NO_LITERAL;
+    std::string_view literalText; // в арене
+    union {
+        int64_t intValue;
+        double floatValue;
+        bool boolValue;
+    } literal = {0};
+    AstArena* arena; // здесь лежат массивы детей и атрибутов
+
+    // Строки атрибута тоже скопированы в арену
+    struct Attribute {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    // Типизированное поле под прежним ключом атрибута; false - у узла его нет
+    bool fieldAttribute(std::string_view key, std::string& value) const;
+
+    // Массивы растут вдвое; старый остаётся в арене до её освобождения
+    ASTNode** children = nullptr;
+    uint32_t childCount = 0;
+    uint32_t childCapacity = 0;
+    Attribute* attributes = nullptr; // упорядочены по ключу, как раньше в std::map
+    uint32_t attributeCount = 0;
+    uint32_t attributeCapacity = 0;
 };
 
 class SemanticAnalyzer {
@@ -241,57 +508,146 @@ private:
     void initializeBuiltins();
     void enterScope();
     void exitScope();
-    Type resolveType(const std::string& typeName, int line);
+    Type resolveType(const std::string& typeName, SourceLoc loc);
+    // Тип объявления узла: разрешается один раз и хранится в узле
+    Type resolveNodeType(ASTNode* node);
     
+    // Обход без рекурсии. visit*/check* не вызывают друг друга, а
+    // добавляют задачи в pending: детей и продолжение, которое доделает
+    // работу узла, когда дети будут проверены. run() переносит pending в
+    // стек tasks так, чтобы задачи выполнялись в порядке добавления. Тип
+    // проверенного выражения остаётся на вершине стека types
+    enum TaskKind {
+        VISIT,                // visitNode
+        CHECK,                // checkExpression
+        ASSIGNMENT_TARGET,    // checkAssignmentTarget
+        DISCARD,              // тип выражения не нужен
+        ENTER_SCOPE,
+        EXIT_SCOPE,
+        ENTER_LOOP,
+        LEAVE_CONTEXT,
+        CLASS_END,
+        METHOD_END,
+        FIELD_INIT,
+        VARIABLE_INIT,
+        ARRAY_ELEMENT,        // index - элемент инициализации
+        CONDITION,            // index - ребёнок с условием
+        SWITCH_BEGIN,
+        SWITCH_CASE,          // index - case, значение которого проверено
+        SWITCH_DEFAULT,       // index - default
+        SWITCH_END,
+        CASE_VALUE,
+        RETURN_VALUE,
+        ASSIGNMENT_END,
+        TARGET_ARRAY,
+        TARGET_FIELD,
+        ARRAY_INIT_ELEMENT,
+        ARRAY_INIT_END,
+        BINARY,
+        UNARY,
+        TERNARY_CONDITION,
+        TERNARY,
+        OBJECT_CALL,
+        CALL_ARGUMENT,        // index - аргумент вызова
+        CALL,
+        ARRAY_ACCESS_ARRAY,
+        ARRAY_ACCESS_INDEX,
+        FIELD,
+        NEW_ARRAY
+    };
+    struct Task {
+        TaskKind kind;
+        ASTNode* node;
+        size_t index;
+        Symbol* saved;        // внешний класс или метод
+    };
+    // Значения case и наличие default у открытых switch
+    struct SwitchLabels {
+        std::set<std::string> values;
+        bool hasDefault = false;
+    };
+
+    void run(TaskKind kind, ASTNode* node);
+    void perform(const Task& task);
+    void schedule(TaskKind kind, ASTNode* node, size_t index = 0, Symbol* saved = nullptr);
+    Type popType();
+
     void visitNode(ASTNode* node);
     void visitProgram(ASTNode* node);
     void visitClassDeclaration(ASTNode* node);
     void visitMethodDeclaration(ASTNode* node);
+    void finishMethodDeclaration(ASTNode* node, FunctionSymbol* outerMethod);
     void visitFieldDeclaration(ASTNode* node);
     void visitVariableDeclaration(ASTNode* node);
+    void finishVariableDeclaration(ASTNode* node);
     void visitBlock(ASTNode* node);
     void visitIfStatement(ASTNode* node);
     void visitWhileStatement(ASTNode* node);
     void visitDoWhileStatement(ASTNode* node);
     void visitForStatement(ASTNode* node);
     void visitSwitchStatement(ASTNode* node);
+    void beginSwitchCases(ASTNode* node);
+    void finishSwitchCase(ASTNode* node, size_t index);
     void visitCase(ASTNode* node);
-    void visitArrayInitialization(ASTNode* varNode, const Type& arrayType);
+    void visitArrayInitialization(ASTNode* varNode);
     void checkBreakValidity(ASTNode* node);
     void checkContinueValidity(ASTNode* node);
     void visitDefault(ASTNode* node);
     void visitReturnStatement(ASTNode* node);
+    void finishReturnStatement(ASTNode* node);
     void visitExpressionStatement(ASTNode* node);
     void visitAssignment(ASTNode* node);
     
-    Type checkAssignmentTarget(ASTNode* node);
-    Type checkExpression(ASTNode* node);
-    Type checkLiteral(ASTNode* node);
-    Type checkVariable(ASTNode* node);
-    Type checkBinaryExpression(ASTNode* node);
+    void checkAssignmentTarget(ASTNode* node);
+    Type arrayTargetType(ASTNode* node, const Type& arrayType, const Type& indexType);
+    Type fieldTargetType(ASTNode* node, const Type& objectType);
+    void checkExpression(ASTNode* node);
+    void checkLiteral(ASTNode* node);
+    void checkVariable(ASTNode* node);
+    void checkBinaryExpression(ASTNode* node);
+    // Тип узла BINARY_EXPR по уже проверенным типам операндов
+    Type binaryExpressionType(ASTNode* node, const Type& leftType, const Type& rightType);
     bool isLValue(ASTNode* node);
-    Type checkOperationType(char op, Type left, Type right, int line);
+    Type checkOperationType(char op, Type left, Type right, SourceLoc loc);
     Type getNumericResultType(Type t1, Type t2);
-    Type checkUnaryExpression(ASTNode* node);
-    Type checkMethodCall(ASTNode* node);
+    void checkUnaryExpression(ASTNode* node);
+    // Тип узла UNARY_EXPR по уже проверенному типу операнда
+    Type unaryExpressionType(ASTNode* node, const Type& exprType);
+    void checkConditionalExpression(ASTNode* node);
+    Type conditionalExpressionType(ASTNode* node, const Type& thenType, const Type& elseType);
+    void checkMethodCall(ASTNode* node);
+    void checkObjectMethodCall(ASTNode* node);
+    void finishMethodCall(ASTNode* node);
     void checkMethodParameters(ASTNode* callNode, FunctionSymbol* method, const std::map<std::string, Type>& genericMap);
     Type resolveTypeWithSubstitution(const Type& type, const std::map<std::string, Type>& genericMap);
-    Type checkArrayAccess(ASTNode* node);
-    Type checkArrayInitializer(ASTNode* node);
-    Type checkFieldAccess(ASTNode* node);
-    Type checkNewExpression(ASTNode* node);
+    void checkArrayAccess(ASTNode* node);
+    void checkArrayInitializer(ASTNode* node);
+    void checkFieldAccess(ASTNode* node);
+    Type fieldAccessType(ASTNode* node, const Type& objectType);
+    void checkNewExpression(ASTNode* node);
     
     bool hasReturnStatement(ASTNode* node);
 
+    // Объявление и поиск имени: в телах методов - в открытых областях, а
+    // затем в currentScope (члены класса или глобальные имена)
+    void declare(Symbol* symbol);
+    Symbol* lookup(SymbolId id) const;
+    Symbol* lookup(const std::string& name) const;
+    Symbol* lookupLocally(SymbolId id) const;
+
     std::unique_ptr<SymbolTable> globalScope;
     SymbolTable* currentScope;
-    std::vector<std::unique_ptr<SymbolTable>> scopes;
+    ScopedSymbolTable localScopes;
     ClassSymbol* currentClass;
     FunctionSymbol* currentMethod;
     std::vector<SemanticError> errors;
     enum ContextType { LOOP_CONTEXT, SWITCH_CONTEXT };
     std::stack<ContextType> contextStack;
     std::vector<Type> switchConditionStack;
+    std::vector<SwitchLabels> switchLabels;
+    std::vector<Task> tasks;
+    std::vector<Task> pending;
+    std::vector<Type> types;
 };
 
 #endif // UTILS_HPP
\ No newline at end of file